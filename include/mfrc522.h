@@ -17,6 +17,8 @@ extern "C" {
 
 #include "utils_tiva.h"
 
+struct SPIDevice;
+
 
 //! \brief Struct UID_t contains ID array, ID size and SAK of current MIFARE card.
 typedef struct __attribute__((packed)) UID {
@@ -26,6 +28,185 @@ typedef struct __attribute__((packed)) UID {
 } UID_t;
 
 
+//! \brief Caller-owned buffer a received frame is read into, see mfrc522_transceiveFrame().
+//!
+//! The FIFO is read straight into \p data, within the SPI transfer. When
+//! CRC_A is checked, its 2 bytes go to \p crc instead, so \p data only needs
+//! room for the payload, e.g. the 16 bytes of a block.
+typedef struct RFIDFrame {
+	uint8_t *data; //!< Payload, owned by the caller.
+	uint8_t capacity; //!< Size of data, in bytes.
+	uint8_t size; //!< Payload bytes received.
+	uint8_t lastBits; //!< Valid bits of the last received byte, 0 if all 8.
+	uint8_t crc[2]; //!< CRC_A received after the payload, if checked.
+} RFIDFrame_t;
+
+
+//! \brief Framing of a frame sent by mfrc522_transceiveRaw(), zero for a standard frame.
+typedef struct RFIDFraming {
+	uint8_t txLastBits; //!< Valid bits of the last byte sent, 0 if all 8, e.g. 7 for a short frame.
+	uint8_t rxAlign; //!< Bit position of the first received bit in rx->data[0], for bit-oriented anticollision.
+	bool txCRC; //!< CRC_A appended by the reader as the frame is sent (TxCRCEn).
+	bool rxCRC; //!< The answer ends with CRC_A, checked and kept apart in rx->crc.
+	bool noParity; //!< No parity bit after each byte, both ways (ParityDisable of MfRxReg).
+	uint16_t timeout; //!< Answer timeout in us, 25us resolution, 0 to keep the current one (50ms).
+} RFIDFraming_t;
+
+
+//! \brief Events reported by mfrc522_monitorPresence().
+typedef enum PresenceEvent {
+	PRESENCE_NONE = 0, //!< No card is tracked and no new card has arrived.
+	PRESENCE_ARRIVED, //!< A new card has been selected and is now tracked.
+	PRESENCE_PRESENT, //!< The tracked card is still in the field.
+	PRESENCE_REMOVED //!< The tracked card has left the field.
+} PresenceEvent_t;
+
+
+//! \brief Register configuration profiles, see mfrc522_setProfile().
+typedef enum RFIDProfile {
+	PROFILE_DEFAULT = 0, //!< 106 kbit/s, RxGain 33dB, applied by init.
+	PROFILE_LONG_RANGE, //!< Maximum RxGain and TX conductance.
+	PROFILE_LOW_POWER, //!< Reduced TX conductance, shorter range.
+	PROFILE_HIGH_BIT_RATE, //!< 212 kbit/s, card must support it (ISO 14443-4 PPS).
+	PROFILE_COUNT
+} RFIDProfile_t;
+
+
+//! \brief Low-power polling, see mfrc522_setLowPower().
+//!
+//! The reader is only awake for wake-up + guard + window of every poll,
+//! duty cycle is this time over the poll interval of the application.
+typedef struct LowPower {
+	uint16_t guard; //!< Field on before REQA, in us, cards power up (ISO 14443-3 allows 5000).
+	uint16_t window; //!< REQA response timeout, in us, 25us resolution.
+} LowPower_t;
+
+
+//! \brief Counters of reader recovery, see mfrc522_recover().
+typedef struct RecoveryStats {
+	uint16_t hangs; //!< Waits that passed their MCU-side deadline.
+	uint16_t cancels; //!< Recovered by cancelling the command.
+	uint16_t rfResets; //!< Recovered by switching the antenna off and on.
+	uint16_t softResets; //!< Recovered by soft reset and configuration.
+	uint16_t hardResets; //!< Recovered by RST pin pulse and configuration.
+	uint16_t failures; //!< Reader still not answering after hard reset.
+} RecoveryStats_t;
+
+
+//! \brief Protocol steps with their own frame retry budget, see RetryPolicy_t.
+typedef enum RetryStep {
+	RETRY_ANTICOLLISION,
+	RETRY_SELECT,
+	RETRY_READ,
+	RETRY_STEPS
+} RetryStep_t;
+
+
+//! \brief Retries of mfrc522_getID() and mfrc522_readBlock(), see mfrc522_setRetryPolicy().
+//!
+//! On STATUS_ERROR, STATUS_COLLISION or STATUS_CRC_WRONG the card answered a
+//! damaged frame and the frame is sent again up to frames[step] times. If it
+//! still fails, or on STATUS_TIMEOUT, mfrc522_getID() starts over with WUPA,
+//! which also wakes cards left halted or half-selected, then after an RF field
+//! reset. Each retry of a call waits \p backoff, doubled at every retry.
+typedef struct RetryPolicy {
+	uint8_t frames[RETRY_STEPS]; //!< Retries of one frame, per step.
+	uint8_t wakeups; //!< Restarts of mfrc522_getID() with WUPA.
+	uint8_t fieldResets; //!< Restarts after an RF field reset, once WUPA restarts are spent.
+	uint16_t backoff; //!< Delay before the first retry, in us.
+} RetryPolicy_t;
+
+
+//! \brief Counters of retries, see mfrc522_getRetryStats().
+typedef struct RetryStats {
+	uint16_t frames; //!< Frames sent again.
+	uint16_t wakeups; //!< mfrc522_getID() restarted with WUPA.
+	uint16_t fieldResets; //!< mfrc522_getID() restarted after an RF field reset.
+	uint16_t recovered; //!< Calls that succeeded after retries.
+	uint16_t failed; //!< Calls that failed after retries.
+} RetryStats_t;
+
+
+//! \brief Register values of the RF front-end, see mfrc522_setTuning().
+typedef struct RFTuning {
+	uint8_t rxGain; //!< RFCfgReg, RxGain in bits 6-4.
+	uint8_t rxThreshold; //!< RxThresholdReg, MinLevel in bits 7-4, CollLevel in bits 2-0.
+	uint8_t demod; //!< DemodReg, AddIQ in bits 7-6.
+	uint8_t cwGsP; //!< CWGsPReg, conductance of p-drivers, field strength.
+	uint8_t modGsP; //!< ModGsPReg, conductance of p-drivers during modulation.
+	uint8_t gsN; //!< GsNReg, conductance of n-drivers, field (bits 7-4) and modulation (bits 3-0).
+} RFTuning_t;
+
+
+//! \brief Health of the reader, see mfrc522_ping() and mfrc522_selfTest().
+//!
+//! Last results are only meaningful once their counter is not zero.
+typedef struct Health {
+	uint8_t version; //!< VersionReg read by the last check.
+	uint8_t ping; //!< Result of the last ping.
+	uint8_t selfTest; //!< Result of the last self-test.
+	uint16_t pings; //!< Pings run.
+	uint16_t pingFailures; //!< Pings failed.
+	uint16_t selfTests; //!< Self-tests run, without reference included.
+	uint16_t selfTestFailures; //!< Self-tests failed.
+} Health_t;
+
+
+#ifndef MFRC522_SS_PORT
+
+//! \brief One of several readers driven by the same MCU, see mfrc522_useReader().
+//!
+//! The driver works on one reader at a time: the platform layer is bound to
+//! its pins and SPI module, and its state below is swapped in. Filled by the
+//! reader init function of the platform, e.g. tiva_mfrc522_initReader().
+typedef struct RFIDReader {
+	void *port; //!< Pins and SPI module: TivaPort_t, AtmegaPort_t or HostPort_t.
+
+	// Internal state, do not modify.
+	uint8_t profile;
+	RFTuning_t tuning;
+	bool tuned;
+	bool asleep;
+	uint16_t guard;
+	uint16_t window;
+	uint16_t timeout;
+	uint8_t rung;
+	RecoveryStats_t recovery;
+	RetryPolicy_t policy;
+	RetryStats_t retries;
+	Health_t health;
+	UID_t tracked;
+	bool tracking;
+} RFIDReader_t;
+
+
+//! \brief Pins and SSI module of a reader on Tiva C, see tiva_mfrc522_initReader().
+typedef struct TivaPort {
+	uint32_t SPIBase; //!< Memory base of the SSI module, may be shared by readers.
+	PortPin_t SS; //!< Slave Select pin.
+	PortPin_t RST; //!< GPIO pin used for reset MFRC522 reader.
+} TivaPort_t;
+
+
+//! \brief Pins of a reader on ATmega, see atmega_mfrc522_initReader().
+typedef struct AtmegaPort {
+	volatile uint8_t *SSPort; //!< Port of Slave Select pin.
+	uint8_t SSPin; //!< Slave Select pin.
+	volatile uint8_t *RSTPort; //!< Port of GPIO pin used for reset MFRC522 reader.
+	uint8_t RSTPin; //!< GPIO pin used for reset MFRC522 reader.
+	uint8_t prescaler; //!< SPI clock of the reader, set by the driver.
+} AtmegaPort_t;
+
+
+//! \brief Device of a reader on Linux host, see host_mfrc522_initReader().
+typedef struct HostPort {
+	const struct SPIDevice *device; //!< Device attached to host-side SPI bus.
+	uint32_t clock; //!< Simulated SPI clock, in Hz, changed by mfrc522_negotiateClock().
+	bool released; //!< RST pin HIGH, set by the driver.
+} HostPort_t;
+
+#endif
+
 
 //! \brief Initialize MFRC522 Reader for Tiva C MCUs.
 //!
@@ -40,9 +221,13 @@ typedef struct __attribute__((packed)) UID {
 //!
 //! SPI module must be configurated in Mode 0.
 //!
-//! \return none.
+//! \return 0 if success, > 0 if error has occured, see mfrc522_init() in mfrc522_port.h.
 //!
-void tiva_mfrc522_init(uint32_t SPIBase, PortPin_t SS, PortPin_t RST);
+#ifdef MFRC522_SS_PORT
+uint8_t tiva_mfrc522_init(); // pins fixed at compile time, see mfrc522_port.h
+#else
+uint8_t tiva_mfrc522_init(uint32_t SPIBase, PortPin_t SS, PortPin_t RST);
+#endif
 
 
 //! \brief Initialize MFRC522 Reader for ATmega MCUs.
@@ -56,18 +241,349 @@ void tiva_mfrc522_init(uint32_t SPIBase, PortPin_t SS, PortPin_t RST);
 //! passing pointers to this function. SPI module is configurated inside
 //! this function.
 //!
+//! \return 0 if success, > 0 if error has occured, see mfrc522_init() in mfrc522_port.h.
+//!
+#ifdef MFRC522_SS_PORT
+uint8_t atmega_mfrc522_init(); // pins fixed at compile time, see mfrc522_port.h
+#else
+uint8_t atmega_mfrc522_init(volatile uint8_t *SSPort, uint8_t SSPin, volatile uint8_t *RSTPort, uint8_t RSTPin);
+#endif
+
+
+//! \brief Initialize MFRC522 Reader on Linux host.
+//!
+//! \param [in] device Device attached to host-side SPI bus,
+//! e.g. mfrc522_sim_device() from mfrc522_sim.h.
+//! \param [in] speed Simulated SPI clock, in Hz.
+//!
+//! \return 0 if success, > 0 if error has occured, see mfrc522_init() in mfrc522_port.h.
+//!
+uint8_t host_mfrc522_init(const struct SPIDevice *device, uint32_t speed);
+
+
+#ifndef MFRC522_SS_PORT
+
+//! \brief Initialize one of several readers, which is then in use.
+//!
+//! As the init function of the platform, with pins, SPI module or device
+//! taken from \p port. Each reader starts with its own profile, timeout,
+//! tuning, retry policy and counters, see mfrc522_useReader().
+//! On Tiva C, readers on their own SSI module get their own SPI clock.
+//!
+//! \param [out] reader Pointer to RFIDReader_t instance, must stay valid.
+//! \param [in] port Pins and SPI module, must stay valid.
+//! \return 0 if success, > 0 if error has occured, see mfrc522_init() in mfrc522_port.h.
+//!
+uint8_t tiva_mfrc522_initReader(RFIDReader_t *reader, TivaPort_t *port);
+uint8_t atmega_mfrc522_initReader(RFIDReader_t *reader, AtmegaPort_t *port);
+uint8_t host_mfrc522_initReader(RFIDReader_t *reader, HostPort_t *port);
+
+
+//! \brief Drive another reader: every following call applies to it.
+//!
+//! The state of the reader in use is saved, the one of \p reader is restored
+//! and the platform layer bound to its pins: a few dozen bytes copied,
+//! nothing sent to the readers. Stats, trace and the modules on top of the
+//! driver (scheduler, events, cache) are not per reader.
+//!
+//! \param [in] reader Pointer to RFIDReader_t instance set up by the platform.
 //! \return none.
 //!
-void atmega_mfrc522_init(volatile uint8_t *SSPort, uint8_t SSPin, volatile uint8_t *RSTPort, uint8_t RSTPin);
+void mfrc522_useReader(RFIDReader_t *reader);
+
+
+//! \brief mfrc522_available() on several readers, their waits overlapping.
+//!
+//! REQA is started on every reader, then each one is polled in turn until
+//! its answer or timeout: an empty field costs one timeout for all readers
+//! instead of one per reader. Readers in low-power polling are polled one
+//! after the other. Read the UIDs with mfrc522_getIDs(). Stack: 2-byte answer,
+//! one RFIDFrame_t and 4 bytes per reader.
+//!
+//! \param [in] readers Array of readers set up by the platform.
+//! \param count Number of readers, at most 8, none is polled above.
+//! \return bit i set if a card answered reader i, the reader in use is kept.
+//!
+uint8_t mfrc522_pollReaders(RFIDReader_t *readers, uint8_t count);
+
+
+//! \brief mfrc522_getID() on several readers, their frames overlapping.
+//!
+//! Anticollision and SELECT run in lockstep: the next frame of every reader
+//! is started, then each one is polled in turn and its answer handled as its
+//! command ends, so air time of all readers overlaps. CRC_A of SELECT is
+//! computed in software. Frame retries follow the policy of each reader, the
+//! other readers keep polling during a back-off; a reader whose card was not
+//! read then starts over on its own with WUPA, as mfrc522_getID(). Stack:
+//! about 34 bytes per reader, SELECT frame included.
+//!
+//! \param [in] readers Array of readers set up by the platform.
+//! \param count Number of readers, at most 8, none is read above.
+//! \param mask Bit i set to read the card of reader i, e.g. the result of
+//! mfrc522_pollReaders().
+//! \param [out] uids Array of \p count UID_t, uids[i] is filled in for reader i.
+//! \return bit i set if the card of reader i was read, the reader in use is kept.
+//!
+uint8_t mfrc522_getIDs(RFIDReader_t *readers, uint8_t count, uint8_t mask, UID_t *uids);
+
+#endif
+
+
+//! \brief Switch register configuration profile.
+//!
+//! Profiles are const tables (in flash on AVR), only the registers that
+//! differ from current profile are written.
+//!
+//! \param profile PROFILE_DEFAULT, PROFILE_LONG_RANGE, PROFILE_LOW_POWER or PROFILE_HIGH_BIT_RATE.
+//! \return none.
+//!
+void mfrc522_setProfile(RFIDProfile_t profile);
+
+
+//! \brief Get current register configuration profile.
+//! \return RFIDProfile_t.
+//!
+RFIDProfile_t mfrc522_getProfile();
+
+
+//! \brief Override the RF front-end registers of every profile.
+//!
+//! Found by mfrc522_calibrate() for an installation, to be stored and set
+//! again after each MCU reset, before or after mfrc522_init(). Kept across
+//! mfrc522_setProfile() and mfrc522_recover(). Modulation width and 100% ASK
+//! stay with the profile, they depend on the bit rate. mfrc522_warmStart()
+//! does not recognize a tuned reader, a cold start follows.
+//!
+//! \param [in] tuning Register values, copied, NULL to go back to the profile
+//! values.
+//! \return none.
+//!
+void mfrc522_setTuning(const RFTuning_t *tuning);
+
+
+//! \brief Get current RF front-end register values.
+//! \param [out] tuning Values of mfrc522_setTuning(), or of current profile.
+//! \return true if set by mfrc522_setTuning(), false if of the profile.
+//!
+bool mfrc522_getTuning(RFTuning_t *tuning);
+
+
+//! \brief Switch antenna off and enter soft power-down.
+//!
+//! Registers are kept, the oscillator is stopped.
+//! Any command wakes the reader up again, see mfrc522_wakeUp().
+//!
+//! \return none.
+//!
+void mfrc522_powerDown();
+
+
+//! \brief Leave soft power-down and switch antenna on.
+//!
+//! Waits for the oscillator and then for the guard time of mfrc522_setLowPower()
+//! before the first command, no-op if the reader is awake.
+//!
+//! \return 0 if success, > 0 if error has occured.
+//!
+uint8_t mfrc522_wakeUp();
+
+
+//! \brief Enable or disable low-power polling.
+//!
+//! When enabled, mfrc522_available() wakes the reader up, sends REQA with
+//! the short timeout \p window and powers the reader down again if no card
+//! answered. If a card answered, the reader stays awake until the next
+//! mfrc522_available() finds an empty field, or until mfrc522_powerDown().
+//!
+//! \param [in] config Guard time and REQA window, copied, NULL to disable.
+//! \return none.
+//!
+void mfrc522_setLowPower(const LowPower_t *config);
+
+
+//! \brief Bring a hung reader back to a configured, idle state.
+//!
+//! Called by the driver when a wait passes its MCU-side deadline, the command
+//! then returns STATUS_HUNG. Every wait is bounded: a command returns within
+//! its timer timeout (50ms by default) plus 12ms of frame time, a wait on the
+//! CRC coprocessor within 1ms. Polls are paced by mfrc522_port_delayUs(), so
+//! real time is the deadline times (1 + SPI read time / 20us) at most.
+//!
+//! Steps are tried until the reader answers with its timer configured:
+//! cancel with Idle command, RF reset (antenna off for 5ms), soft reset, then
+//! RST pin pulse, both followed by the configuration of current profile.
+//! A hang right after a recovery starts one step further. Recovery takes
+//! at most about 30ms.
+//!
+//! \return 0 if success, STATUS_ERROR if the reader does not answer anymore.
+//!
+uint8_t mfrc522_recover();
+
+
+//! \brief Get counters of reader recovery.
+//! \param [out] stats Pointer to RecoveryStats_t instance.
+//! \return none.
+//!
+void mfrc522_getRecoveryStats(RecoveryStats_t *stats);
+
+
+//! \brief Reset counters of reader recovery.
+//! \return none.
+//!
+void mfrc522_resetRecoveryStats();
+
+
+//! \brief Step the SPI clock up to the fastest reliable one.
+//!
+//! Clocks of the platform are tried from the slowest: each must pass a
+//! loopback test, VersionReg then 4 full FIFOs of pseudo-random bytes
+//! written and read back. The clock one step below the fastest that passed
+//! is kept as a safety margin, the fastest of the platform if all passed.
+//! After a failed step the reader is soft-reset and configured again.
+//! Called by the init functions of Tiva C and ATmega, host keeps its clock.
+//!
+//! \return SPI clock in Hz, 0 if even the slowest clock fails.
+//!
+uint32_t mfrc522_negotiateClock();
+
+
+//! \brief Run the loopback test at the current SPI clock, negotiate again if it fails.
+//!
+//! To be called between commands now and then, wiring degrades with
+//! temperature and vibration. Costs about 600 bytes of SPI transfers.
+//!
+//! \return true if passed, false if the clock had to be negotiated again.
+//!
+bool mfrc522_verifyClock();
+
+
+//! \brief Check the reader answers and its registers hold their value, in 6 SPI frames.
+//!
+//! VersionReg is read, then 0x55 and 0xAA are written to TReloadRegL and read
+//! back, which is restored. Neither the field nor the FIFO is touched, so the
+//! ping can run between any two polls, and costs 12 bytes of SPI transfers.
+//!
+//! \return 0 if passed, STATUS_ERROR if not.
+//!
+uint8_t mfrc522_ping();
+
+
+//! \brief Run the digital self-test of the reader, datasheet ch. 16.1.1.
+//!
+//! After a soft reset, the internal buffer is cleared and the CRC coprocessor
+//! runs in test mode: the 64 bytes it writes to the FIFO are compared with the
+//! reference of the chip version, MFRC522 v1.0 or v2.0. The reader is then
+//! soft-reset and configured again with its profile and tuning, as by
+//! mfrc522_recover(). Costs about 110 register accesses and two soft resets.
+//!
+//! The field is off during the soft resets, so cards in the field go back to
+//! IDLE state: run it between polls while mfrc522_available() is false.
+//! In low-power polling the reader is left awake until the next poll.
+//!
+//! \return 0 if passed, STATUS_INVALID if no reference is known for the
+//! version (clones), STATUS_TIMEOUT if the test did not end,
+//! STATUS_ERROR if the reader does not answer or the output differs.
+//!
+uint8_t mfrc522_selfTest();
+
+
+//! \brief Get results and counters of health checks.
+//! \param [out] stats Pointer to Health_t instance.
+//! \return none.
+//!
+void mfrc522_getHealth(Health_t *stats);
+
+
+//! \brief Reset results and counters of health checks.
+//! \return none.
+//!
+void mfrc522_resetHealth();
+
+
+//! \brief Set the retry policy, no retry by default.
+//!
+//! Frame retries resend a frame the card has answered: a failed read is
+//! harmless to send again, a failed SELECT leaves the card in IDLE state and
+//! is caught by the WUPA restart. A silent card has most likely lost its state
+//! to a damaged command, so a timeout is not worth a frame retry. The field
+//! reset takes 10ms, antenna off then power-up of the cards.
+//!
+//! \param [in] policy Retry budgets, copied, NULL to disable retries.
+//! \return none.
+//!
+void mfrc522_setRetryPolicy(const RetryPolicy_t *policy);
+
+
+//! \brief Get counters of retries.
+//! \param [out] stats Pointer to RetryStats_t instance.
+//! \return none.
+//!
+void mfrc522_getRetryStats(RetryStats_t *stats);
+
+
+//! \brief Reset counters of retries.
+//! \return none.
+//!
+void mfrc522_resetRetryStats();
+
+
+//! \brief Send a standard frame to the card and read its answer in place.
+//!
+//! CRC_A of the answer is checked in software while it is read, without
+//! another transfer to the CRC coprocessor. A 4-bit ACK/NAK is returned in
+//! \p rx as 1 byte with lastBits 4.
+//!
+//! Stack: no buffer, the answer goes to \p rx only.
+//!
+//! \param [in] txBuffer Frame to send, CRC_A included if the command has one.
+//! \param txSize Size of txBuffer, in bytes.
+//! \param [in,out] rx Caller buffer of the answer, NULL if none is expected.
+//! \param checkCRC The answer ends with CRC_A, to be checked and kept apart in rx->crc.
+//! \return 0 if success, STATUS_NO_ROOM if the payload exceeds rx->capacity,
+//! STATUS_CRC_WRONG, STATUS_MIFARE_NACK if a 4-bit NAK came instead of a
+//! CRC_A frame, > 0 for other errors.
+//!
+uint8_t mfrc522_transceiveFrame(const void *txBuffer, uint8_t txSize, RFIDFrame_t *rx, bool checkCRC);
+
+
+//! \brief Send any frame to the card, with bit-level framing, and read its answer in place.
+//!
+//! For commands the driver does not know, e.g. proprietary commands of a tag.
+//! The frame goes through the same path as the driver's own commands: options
+//! left at 0 cost nothing, others a register write before the frame and one
+//! after, to restore it. The card is expected selected (mfrc522_getID()) or
+//! woken up by a short frame sent with txLastBits 7.
+//!
+//! Stack: no buffer.
+//!
+//! \param [in] txBuffer Frame to send, without CRC_A if framing->txCRC.
+//! \param txSize Size of txBuffer, in bytes, the last one partial if framing->txLastBits.
+//! \param [in] framing Pointer to RFIDFraming_t instance.
+//! \param [in,out] rx Caller buffer of the answer, see RFIDFrame_t. NULL to only
+//! transmit, e.g. HLTA: the call returns once the frame is sent.
+//! \return as mfrc522_transceiveFrame(). On STATUS_COLLISION, rx holds the bits
+//! received, cleared from the first collision on. STATUS_INVALID, nothing sent,
+//! if framing->txLastBits or framing->rxAlign is over 7.
+//!
+uint8_t mfrc522_transceiveRaw(const void *txBuffer, uint8_t txSize,
+								const RFIDFraming_t *framing, RFIDFrame_t *rx);
 
 
 //! \brief Check if new MIFARE card is avaible
+//!
+//! Stack: 2-byte ATQA and one RFIDFrame_t.
+//!
 //! \return true or false
 //!
 bool mfrc522_available();
 
 
 //! \brief Get card'ID.
+//!
+//! Anticollision answers are read into the SELECT frame of their cascade
+//! level, so the UID is only copied once, into \p uid.
+//! Stack: 10 bytes (SELECT frame, SAK) and one RFIDFrame_t.
+//!
 //! \param [out] uid Pointer to UID_t instance.
 //! \return 0 if success, > 0 if error has occured.
 //! 
@@ -75,10 +591,85 @@ uint8_t mfrc522_getID(UID_t *uid);
 
 
 //! \brief Send command HALTA to halt MIFARE card.
+//!
+//! Stack: 4-byte frame.
+//!
 //! \return 0 if success, > 0 if error has occured.
 //! 
 uint8_t mfrc522_sendHaltA();
 
+
+//! \brief Authenticate a sector of MIFARE Classic card.
+//!
+//! Stack: 12-byte frame.
+//!
+//! \param cmd MIFARE_CMD_AUTHENT1A or MIFARE_CMD_AUTHENT1B.
+//! \param block Any block of the sector to be accessed.
+//! \param [in] key 6-byte key A or key B.
+//! \param [in] uid Pointer to UID_t instance of selected card.
+//! \return 0 if success, > 0 if error has occured.
+//!
+uint8_t mfrc522_authenticate(uint8_t cmd, uint8_t block, const uint8_t *key, const UID_t *uid);
+
+
+//! \brief Leave authenticated state, must be called before selecting another card.
+//! \return none.
+//!
+void mfrc522_stopCrypto();
+
+
+//! \brief Read one block from MIFARE card.
+//!
+//! MIFARE Classic needs mfrc522_authenticate() first.
+//! MIFARE Ultralight returns 4 pages starting at \p block.
+//! The block is read from the FIFO straight into \p buffer.
+//! Stack: 4-byte frame and one RFIDFrame_t.
+//!
+//! \param block Block (or page) address.
+//! \param [out] buffer 16-byte buffer.
+//! \return 0 if success, > 0 if error has occured.
+//!
+uint8_t mfrc522_readBlock(uint8_t block, void *buffer);
+
+
+//! \brief Write one block to MIFARE card.
+//!
+//! MIFARE Classic needs mfrc522_authenticate() first.
+//! MIFARE Ultralight only stores the first 4 bytes (COMPATIBILITY WRITE).
+//! Stack: 18-byte frame and one RFIDFrame_t.
+//!
+//! \param block Block (or page) address.
+//! \param [in] buffer 16-byte data.
+//! \return 0 if success, > 0 if error has occured.
+//!
+uint8_t mfrc522_writeBlock(uint8_t block, const void *buffer);
+
+
+//! \brief Check if a selected card is still in the field.
+//!
+//! The card is probed with the cheapest command for its type
+//! (READ for Ultralight, 4-bit NAK of an unauthenticated READ for Classic,
+//! HLTA otherwise) and then reselected with its known UID,
+//! so it is left ACTIVE without running anticollision again.
+//! Stack: 18-byte answer, then 10 bytes to reselect, and one RFIDFrame_t.
+//!
+//! \param [in] uid Pointer to UID_t instance returned by mfrc522_getID().
+//! \return true if the card answered, false otherwise.
+//!
+bool mfrc522_checkPresence(const UID_t *uid);
+
+
+//! \brief Track arrival and removal of one card.
+//!
+//! Call it periodically instead of looping mfrc522_available().
+//! While a card is tracked, only mfrc522_checkPresence() is used,
+//! with a 5ms timeout, so removal is detected within a few milliseconds.
+//!
+//! \param [out] uid Tracked card, valid unless PRESENCE_NONE is returned.
+//! \return PRESENCE_NONE, PRESENCE_ARRIVED, PRESENCE_PRESENT or PRESENCE_REMOVED.
+//!
+PresenceEvent_t mfrc522_monitorPresence(UID_t *uid);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,77 @@
+
+//! \file mfrc522_allowlist.h
+//! \brief Read-only UID index of enrolled cards, placed in flash.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! The index is a blob generated on host by mfrc522_allowlist from a CSV file
+//! (one "UID[,record]" per line), compiled into the firmware as a const array
+//! (PROGMEM on AVR). Lookup needs no RAM whatever the number of cards.
+//!
+//! Blob layout, little-endian:
+//! - header, 16 bytes: "UIDX", version, 0, number of 4-, 7- and 10-byte UIDs
+//!   (3 x uint16), CRC-16/CCITT of the rest of the blob, 2 reserved bytes.
+//! - UIDs of each size, sorted bytewise: the 4-byte table, then 7-byte, then 10-byte.
+//! - uint16 record numbers, in the same order.
+//!
+//! Lookup alternates interpolation and bisection steps on the sorted table:
+//! O(log log n) probes on random UIDs, O(log n) at worst.
+
+
+#ifndef __RFID_ALLOWLIST__
+#define __RFID_ALLOWLIST__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mfrc522.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#elif !defined(PROGMEM)
+#define PROGMEM
+#endif
+
+
+#define ALLOWLIST_HEADER	16
+#define ALLOWLIST_VERSION	1
+
+//! Returned by mfrc522_allowlistLookup() if the card is not enrolled.
+#define ALLOWLIST_NOT_FOUND	0xFFFF
+
+
+//! \brief Check magic, version and CRC of an index.
+//!
+//! Reads the whole blob, call it once at startup.
+//!
+//! \param [in] blob Index in flash.
+//! \return true if the index is valid.
+//!
+bool mfrc522_allowlistCheck(const uint8_t *blob);
+
+
+//! \brief Get number of cards in an index.
+//! \param [in] blob Index in flash.
+//! \return Number of UIDs of all sizes.
+//!
+uint16_t mfrc522_allowlistCount(const uint8_t *blob);
+
+
+//! \brief Look up a card.
+//! \param [in] blob Index in flash.
+//! \param [in] uid Card from mfrc522_getID().
+//! \return Record number of the card, ALLOWLIST_NOT_FOUND if not enrolled.
+//!
+uint16_t mfrc522_allowlistLookup(const uint8_t *blob, const UID_t *uid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_ALLOWLIST__ */
+
+/**************************** End of File ************************************/
@@ -0,0 +1,120 @@
+
+//! \file mfrc522_cache.h
+//! \brief UID-keyed cache of MIFARE card blocks
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#ifndef __RFID_CACHE__
+#define __RFID_CACHE__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mfrc522.h"
+
+
+//! Number of cards that can be cached at the same time.
+#ifndef MFRC522_CACHE_CARDS
+#define MFRC522_CACHE_CARDS		2
+#endif
+
+//! Number of 16-byte blocks shared by all cached cards.
+#ifndef MFRC522_CACHE_BLOCKS
+#define MFRC522_CACHE_BLOCKS	8
+#endif
+
+
+//! \brief Hit/miss statistics of the cache.
+typedef struct CacheStats {
+	uint32_t hits; //!< Reads served from RAM.
+	uint32_t misses; //!< Reads that went to the card.
+	uint32_t validations; //!< Version block reads done by mfrc522_cacheOpen().
+	uint32_t invalidations; //!< Cards dropped because of version change or TTL.
+	uint32_t evictions; //!< Entries dropped to make room for new ones.
+} CacheStats_t;
+
+
+//! \brief Configure the cache and drop all entries.
+//!
+//! \param versionBlock Block holding the per-card change counter.
+//! Application must modify this block whenever it changes card content.
+//! \param ttl Maximum age of a cached card, in ticks of \p now. 0 = no TTL.
+//! \param now Tick source, NULL if TTL is not used.
+//! \return none.
+//!
+void mfrc522_cacheInit(uint8_t versionBlock, uint32_t ttl, uint32_t (*now)(void));
+
+
+//! \brief Validate the cache of a selected card.
+//!
+//! Reads the version block once (authenticate its sector first on MIFARE Classic),
+//! cached blocks of this card are dropped if it has changed or TTL has expired.
+//!
+//! \param [in] uid Pointer to UID_t instance of selected card.
+//! \return 0 if success, > 0 if error has occured.
+//!
+uint8_t mfrc522_cacheOpen(const UID_t *uid);
+
+
+//! \brief Look up one block in RAM only, no card access.
+//! \param [in] uid Pointer to UID_t instance of selected card.
+//! \param block Block address.
+//! \param [out] buffer 16-byte buffer.
+//! \return true if hit, false otherwise.
+//!
+bool mfrc522_cacheLookup(const UID_t *uid, uint8_t block, void *buffer);
+
+
+//! \brief Read one block, from RAM if cached, from the card otherwise.
+//!
+//! On MIFARE Classic, authenticate the sector before a miss,
+//! or use mfrc522_cacheLookup() to know if it is needed.
+//!
+//! \param [in] uid Pointer to UID_t instance of selected card.
+//! \param block Block address.
+//! \param [out] buffer 16-byte buffer.
+//! \return 0 if success, > 0 if error has occured.
+//!
+uint8_t mfrc522_cacheRead(const UID_t *uid, uint8_t block, void *buffer);
+
+
+//! \brief Write one block to the card and update the cache (write-through).
+//! \param [in] uid Pointer to UID_t instance of selected card.
+//! \param block Block address.
+//! \param [in] buffer 16-byte data.
+//! \return 0 if success, > 0 if error has occured.
+//!
+uint8_t mfrc522_cacheWrite(const UID_t *uid, uint8_t block, const void *buffer);
+
+
+//! \brief Drop all cached blocks of one card.
+//! \param [in] uid Pointer to UID_t instance.
+//! \return none.
+//!
+void mfrc522_cacheInvalidate(const UID_t *uid);
+
+
+//! \brief Get statistics of the cache.
+//! \param [out] stats Pointer to CacheStats_t instance.
+//! \return none.
+//!
+void mfrc522_cacheGetStats(CacheStats_t *stats);
+
+
+//! \brief Reset statistics of the cache.
+//! \return none.
+//!
+void mfrc522_cacheResetStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_CACHE__ */
+
+/**************************** End of File ************************************/
@@ -0,0 +1,63 @@
+
+//! \file mfrc522_calibration.h
+//! \brief Calibration of the RF front-end against a reference card
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Installations differ (metal doors, thick glass, antennas), so do the best
+//! gain, threshold and driver conductances. Hold a reference card where it
+//! must still be read, e.g. at the edge of the wanted range, and call
+//! mfrc522_calibrate() once at installation.
+//!
+//! Every candidate tuning is scored by activations of the card from power-up:
+//! mfrc522_powerDown(), mfrc522_wakeUp(), then REQA, anticollision and SELECT.
+//! Activations succeeding at first try count, their latency breaks ties.
+//! Retries of mfrc522_setRetryPolicy() should be off while calibrating.
+//!
+//! Field strength (conductance of TX drivers) and RxGain are swept together,
+//! since a weak card needs both, then MinLevel, modulation conductance and
+//! the I/Q demodulator one by one. A candidate replaces the best tuning only
+//! if strictly better: on ties the tuning in use, then the weaker field and
+//! the lower gain are kept, drawing less current and picking up less noise.
+
+
+#ifndef __RFID_CALIBRATION__
+#define __RFID_CALIBRATION__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mfrc522.h"
+
+
+//! \brief Outcome of mfrc522_calibrate().
+typedef struct CalibrationResult {
+	RFTuning_t tuning; //!< Best tuning, applied, to be stored for mfrc522_setTuning().
+	uint8_t before; //!< First-try activations with the tuning in use before.
+	uint8_t after; //!< First-try activations with the best tuning.
+	uint32_t latency; //!< Mean activation time with the best tuning, in ticks of now.
+	uint8_t candidates; //!< Tunings tried.
+} CalibrationResult_t;
+
+
+//! \brief Sweep the RF front-end against a reference card and apply the best tuning.
+//! \param [in] card UID of the reference card, NULL for any card.
+//! \param trials Activations per candidate tuning.
+//! \param now Function returning a free-running tick counter, e.g. micros().
+//! \param [out] result Best tuning and its score.
+//! \return true if the card was activated, false if never: the tuning in use is kept.
+//!
+bool mfrc522_calibrate(const UID_t *card, uint8_t trials, uint32_t (*now)(void),
+						CalibrationResult_t *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_CALIBRATION__ */
+
+/**************************** End of File ************************************/
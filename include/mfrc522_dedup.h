@@ -0,0 +1,96 @@
+
+//! \file mfrc522_dedup.h
+//! \brief Time-windowed suppression of repeated card reads
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! On conveyors the same tag is read many times per second. Pass every UID
+//! from mfrc522_getID() to mfrc522_dedupCheck(): a new card is reported at
+//! once, then its reads are suppressed as long as it is seen again within the
+//! window. A card not seen for the window is reported again.
+//!
+//! Cards are kept in a fixed open-addressed table of last-seen ticks. A card
+//! probes MFRC522_DEDUP_PROBES slots from its hash; when all are live, the
+//! least recently seen is evicted, and the evicted card would be reported
+//! again on its next read. Evictions count the pressure on the table.
+
+
+#ifndef __RFID_DEDUP__
+#define __RFID_DEDUP__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mfrc522.h"
+
+
+//! Number of cards tracked at the same time, power of 2.
+#ifndef MFRC522_DEDUP_SLOTS
+#ifdef __AVR__
+#define MFRC522_DEDUP_SLOTS		8
+#else
+#define MFRC522_DEDUP_SLOTS		32
+#endif
+#endif
+
+//! Slots probed per card, the set from which the LRU card is evicted.
+#ifndef MFRC522_DEDUP_PROBES
+#define MFRC522_DEDUP_PROBES	4
+#endif
+
+
+//! \brief Counters of the de-dup filter.
+typedef struct DedupStats {
+	uint32_t reported; //!< Reads reported as new.
+	uint32_t suppressed; //!< Repeated reads suppressed.
+	uint32_t evictions; //!< Cards dropped while still within the window.
+	uint8_t occupancy; //!< Cards within the window now.
+	uint8_t maxOccupancy; //!< Most cards within the window at the same time.
+} DedupStats_t;
+
+
+//! \brief Configure the filter and forget all cards.
+//! \param window Repeats within this time are suppressed, in ticks of \p now.
+//! \param now Function returning a free-running tick counter, e.g. micros().
+//! \return none.
+//!
+void mfrc522_dedupInit(uint32_t window, uint32_t (*now)(void));
+
+
+//! \brief Record a read and tell whether to report it.
+//! \param [in] uid Card from mfrc522_getID().
+//! \return true if the card is new, false if it is a repeat within the window.
+//!
+bool mfrc522_dedupCheck(const UID_t *uid);
+
+
+//! \brief Forget one card, its next read is reported.
+//! \param [in] uid Card to forget.
+//! \return none.
+//!
+void mfrc522_dedupForget(const UID_t *uid);
+
+
+//! \brief Get counters of the filter.
+//! \param [out] stats Pointer to DedupStats_t instance.
+//! \return none.
+//!
+void mfrc522_dedupGetStats(DedupStats_t *stats);
+
+
+//! \brief Reset counters of the filter.
+//! \return none.
+//!
+void mfrc522_dedupResetStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_DEDUP__ */
+
+/**************************** End of File ************************************/
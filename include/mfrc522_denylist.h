@@ -0,0 +1,89 @@
+
+//! \file mfrc522_denylist.h
+//! \brief Bloom filter of revoked card UIDs, in EEPROM or flash.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Checked right after mfrc522_getID(): a card not in the filter is surely
+//! not revoked, a positive is a revoked card or a false positive, to be
+//! confirmed against the exact list (uplink, or mfrc522_denylist -q on host).
+//! A check costs a few hash probes, whatever the number of revoked cards.
+//!
+//! The filter is generated on host by mfrc522_denylist for a target
+//! false-positive rate, and can be extended in place by mfrc522_denylistAdd().
+//! Bits are stored inverted: an erased filter (0xFF) is empty and adding a card
+//! only clears bits, so flash pages are updated without erasing them.
+//!
+//! Layout, little-endian:
+//! - header, 16 bytes: "UIDB", version, number of hashes, 2 reserved bytes,
+//!   number of bits (uint32), hash seed (uint32).
+//! - bits, (number of bits + 7) / 8 bytes.
+//!
+//! Positions are derived by double hashing of the FNV-1a hash of UID size and bytes.
+
+
+#ifndef __RFID_DENYLIST__
+#define __RFID_DENYLIST__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mfrc522.h"
+
+
+#define DENYLIST_HEADER		16
+#define DENYLIST_VERSION	1
+#define DENYLIST_MAX_HASHES	16
+
+
+//! \brief Access to the memory holding the filter, e.g. eeprom_read_byte() on AVR.
+typedef struct DenylistMemory {
+	uint8_t (*read)(void *context, uint32_t address); //!< Read one byte of the filter.
+	void (*write)(void *context, uint32_t address, uint8_t value); //!< Write one byte, NULL if read-only.
+	void *context; //!< Passed to read and write.
+} DenylistMemory_t;
+
+
+//! \brief Write an empty filter.
+//! \param [in] memory Writable memory of DENYLIST_HEADER + (bits + 7) / 8 bytes.
+//! \param bits Number of bits of the filter.
+//! \param hashes Number of bit positions per card, 1 to DENYLIST_MAX_HASHES.
+//! \param seed Hash seed.
+//! \return true if success, false if parameters are invalid or memory is read-only.
+//!
+bool mfrc522_denylistFormat(const DenylistMemory_t *memory, uint32_t bits, uint8_t hashes, uint32_t seed);
+
+
+//! \brief Check the header of a filter.
+//! \param [in] memory Memory holding the filter.
+//! \return true if valid.
+//!
+bool mfrc522_denylistValid(const DenylistMemory_t *memory);
+
+
+//! \brief Add a revoked card, in place.
+//! \param [in] memory Memory holding the filter.
+//! \param [in] uid Revoked card.
+//! \return true if success, false if the filter is invalid or memory is read-only.
+//!
+bool mfrc522_denylistAdd(const DenylistMemory_t *memory, const UID_t *uid);
+
+
+//! \brief Check a card against the filter.
+//! \param [in] memory Memory holding the filter.
+//! \param [in] uid Card from mfrc522_getID().
+//! \return true if the card may be revoked (or the filter is invalid), false if surely not.
+//!
+bool mfrc522_denylistCheck(const DenylistMemory_t *memory, const UID_t *uid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_DENYLIST__ */
+
+/**************************** End of File ************************************/
@@ -0,0 +1,81 @@
+
+//! \file mfrc522_events.h
+//! \brief Debounced card arrival and removal events of MFRC522 reader
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! mfrc522_eventsProcess() runs one step of mfrc522_monitorPresence() and calls
+//! back the application only when something changed:
+//!
+//! - PRESENCE_ARRIVED when a new card is selected.
+//! - PRESENCE_REMOVED once the card has been missing for the debounce time.
+//!   If it comes back before, no event is emitted at all, so a card held
+//!   at the edge of the field is reported once.
+//! - PRESENCE_PRESENT while the card stays, at most once per re-report window.
+//!
+//! It can be called from the main loop or from a timer ISR, the callback runs
+//! in the same context. The reader must not be used by other code meanwhile.
+
+
+#ifndef __RFID_EVENTS__
+#define __RFID_EVENTS__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mfrc522.h"
+
+
+//! \brief Called on every event.
+//! \param event PRESENCE_ARRIVED, PRESENCE_PRESENT or PRESENCE_REMOVED.
+//! \param [in] uid Card of the event.
+//! \param context Pointer given to mfrc522_eventsInit().
+typedef void (*CardCallback_t)(PresenceEvent_t event, const UID_t *uid, void *context);
+
+
+//! \brief Event windows, in ticks of the clock source.
+typedef struct EventConfig {
+	uint32_t debounce; //!< A card must be missing this long to be removed.
+	uint32_t rereport; //!< Minimum time between PRESENCE_PRESENT events, 0 = never reported.
+} EventConfig_t;
+
+
+//! \brief Configure the event layer, no card is tracked.
+//! \param [in] config Event windows, copied.
+//! \param callback Function called on every event.
+//! \param context Passed to \p callback.
+//! \param now Function returning a free-running tick counter, e.g. micros().
+//! \return none.
+//!
+void mfrc522_eventsInit(const EventConfig_t *config, CardCallback_t callback,
+						void *context, uint32_t (*now)(void));
+
+
+//! \brief Poll the reader once and emit the events.
+//!
+//! Call it periodically, e.g. when mfrc522_schedulerWait() returns 0.
+//! Up to two events are emitted by one call:
+//! PRESENCE_REMOVED of a card replaced by another one, then PRESENCE_ARRIVED.
+//!
+//! \return true if the callback was called.
+//!
+bool mfrc522_eventsProcess();
+
+
+//! \brief Get the tracked card.
+//! \param [out] uid Pointer to UID_t instance.
+//! \return true if a card is tracked, removal pending included.
+//!
+bool mfrc522_eventsCard(UID_t *uid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_EVENTS__ */
+
+/**************************** End of File ************************************/
@@ -0,0 +1,196 @@
+
+//! \file mfrc522_port.h
+//! \brief Platform layer used by MFRC522 driver core.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Every platform (mfrc522_atmega.c, mfrc522_tiva.c, mfrc522_host.c)
+//! implements these functions and calls mfrc522_init() from its
+//! own init function after SPI module is ready.
+//!
+//! Fixed board layouts can define the pins at compile time, then
+//! SS control and SPI transfer are inlined into every register access:
+//! - ATmega: MFRC522_SS_PORT/MFRC522_SS_PIN (e.g. PORTB/2),
+//!   MFRC522_RST_PORT/MFRC522_RST_PIN.
+//! - Tiva C: MFRC522_SPI_BASE (e.g. SSI0_BASE),
+//!   MFRC522_SS_PORT/MFRC522_SS_PIN (e.g. GPIO_PORTA_BASE/GPIO_PIN_3),
+//!   MFRC522_RST_PORT/MFRC522_RST_PIN.
+//! The init function of the platform then takes no argument.
+//! On ATmega328P, a register read is estimated at 21 CPU cycles besides the
+//! SPI transfer itself instead of 117 (20 instead of 119 for a write). These
+//! are estimates from a hand translation of mfrc522_read()/mfrc522_write()
+//! compiled with LLVM llc, not measurements of an avr-gcc build.
+
+
+#ifndef __RFID_PORT__
+#define __RFID_PORT__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "mfrc522.h"
+
+
+//! Fastest SPI clock of MFRC522, see datasheet ch. 8.1.2.
+#define MFRC522_SPI_MAX		10000000UL
+
+
+#if defined(MFRC522_SS_PORT) && defined(__AVR__)
+
+#include <avr/io.h>
+
+static inline void mfrc522_port_select() {
+	MFRC522_SS_PORT &= ~(1 << MFRC522_SS_PIN);
+}
+
+static inline void mfrc522_port_deselect() {
+	MFRC522_SS_PORT |= (1 << MFRC522_SS_PIN);
+}
+
+static inline uint8_t mfrc522_port_transfer(uint8_t data) {
+	SPDR = data;
+	while (!(SPSR & (1 << SPIF))) {
+		// wait for flag interrupt
+	}
+	return SPDR;
+}
+
+#elif defined(MFRC522_SS_PORT)
+
+#include <stdbool.h>
+
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_ssi.h"
+
+// GPIO data register is masked by address bits 9-2, see GPIOPinWrite()
+static inline void mfrc522_port_select() {
+	HWREG(MFRC522_SS_PORT + GPIO_O_DATA + (MFRC522_SS_PIN << 2)) = 0;
+}
+
+static inline void mfrc522_port_deselect() {
+	HWREG(MFRC522_SS_PORT + GPIO_O_DATA + (MFRC522_SS_PIN << 2)) = MFRC522_SS_PIN;
+}
+
+// TX FIFO is always empty here since every byte is received before the next one
+static inline uint8_t mfrc522_port_transfer(uint8_t data) {
+	HWREG(MFRC522_SPI_BASE + SSI_O_DR) = data;
+	while (!(HWREG(MFRC522_SPI_BASE + SSI_O_SR) & SSI_SR_RNE)) {
+	}
+	return HWREG(MFRC522_SPI_BASE + SSI_O_DR);
+}
+
+#else
+
+//! \brief Pull Slave Select pin LOW.
+//! \return none.
+//!
+void mfrc522_port_select();
+
+
+//! \brief Pull Slave Select pin HIGH.
+//! \return none.
+//!
+void mfrc522_port_deselect();
+
+
+//! \brief Transfer 1 byte on SPI bus of the reader.
+//! \param data Byte to send.
+//! \return received byte.
+//!
+#define mfrc522_port_transfer(data)	spi_transfer_byte(data)
+
+
+//! \brief Bind select, transfer, reset and clock to the pins and SPI module of a reader.
+//! Called by mfrc522_useReader(), and between polls of mfrc522_pollReaders().
+//! \param [in] port TivaPort_t, AtmegaPort_t or HostPort_t of the platform.
+//! \return none.
+//!
+void mfrc522_port_bind(void *port);
+
+#endif
+
+
+//! \brief Release MFRC522 reader from hard power-down (RST pin HIGH), without waiting.
+//! Must not reset a reader that is already running, see mfrc522_init().
+//! \return none.
+//!
+void mfrc522_port_hardReset();
+
+
+//! \brief Pulse RST pin LOW then HIGH, resetting a running reader, without waiting.
+//! Used by mfrc522_recover() as its last step.
+//! \return none.
+//!
+void mfrc522_port_resetPulse();
+
+
+//! \brief Set SPI clock of the reader, used by mfrc522_negotiateClock().
+//! \param step Clock of the platform, 0 is the slowest (bring-up) clock,
+//! faster ones follow, up to MFRC522_SPI_MAX.
+//! \return clock in Hz, 0 if \p step is past the fastest clock (clock unchanged).
+//!
+uint32_t mfrc522_port_setClock(uint8_t step);
+
+
+//! \brief Delay in millisecond.
+//! \param ms millisecond.
+//! \return none.
+//!
+void mfrc522_port_delay(uint16_t ms);
+
+
+//! \brief Delay in microsecond, used while polling the reader.
+//! \param us microsecond.
+//! \return none.
+//!
+void mfrc522_port_delayUs(uint16_t us);
+
+
+//! \brief Reset and configurate MFRC522 reader, common to all platforms.
+//!
+//! If the reader kept power and one of the profiles across an MCU reset
+//! (warm start), it is only brought to idle state. Otherwise it is
+//! soft-reset and configured, polling for readiness instead of fixed delays:
+//! the reader is up once VersionReg reads a known version and the PowerDown
+//! bit is cleared. Every wait is bounded, an absent reader takes 10 ms.
+//!
+//! \return 0 if success, > 0 if error has occured (STATUS_TIMEOUT if the reader
+//! does not get ready, STATUS_ERROR if it does not answer).
+//!
+uint8_t mfrc522_init();
+
+
+//! \brief mfrc522_init() at the slowest clock, then as fast as the wiring allows.
+//!
+//! Used by the platforms whose SPI clock can be changed after init,
+//! see mfrc522_negotiateClock().
+//!
+//! \return as mfrc522_init(), STATUS_ERROR if no clock passes the loopback test.
+//!
+uint8_t mfrc522_bringUp();
+
+
+#ifndef MFRC522_SS_PORT
+
+//! \brief Set up a reader with the state of a reader after power-on, bound to \p port,
+//! and use it. Called by the reader init function of the platform before mfrc522_bringUp().
+//! \param [out] reader Pointer to RFIDReader_t instance.
+//! \param [in] port Pins and SPI module, passed to mfrc522_port_bind().
+//! \return none.
+//!
+void mfrc522_attachReader(RFIDReader_t *reader, void *port);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_PORT__ */
+
+/**************************** End of File ************************************/
@@ -0,0 +1,101 @@
+
+//! \file mfrc522_queue.h
+//! \brief Lock-free queue of card events from ISR to main loop.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Fixed-capacity single-producer/single-consumer ring: card detection running
+//! in a timer ISR (or a thread on host) pushes, the main loop drains.
+//! Neither side disables interrupts or blocks. Indexes are C11 atomics with
+//! acquire/release ordering, single bytes with a compiler barrier on AVR
+//! (where byte access is atomic and there is no reordering in hardware), and
+//! wherever MFRC522_QUEUE_NO_ATOMICS is defined.
+//!
+//! When the ring is full, the new event is dropped and counted.
+//!
+//! Wiring with mfrc522_events.h:
+//! \code
+//! mfrc522_queueInit(micros);
+//! mfrc522_eventsInit(&config, mfrc522_queueCallback, NULL, micros); // timer ISR calls mfrc522_eventsProcess()
+//! count = mfrc522_queueDrain(events, 4); // main loop
+//! \endcode
+
+
+#ifndef __RFID_QUEUE__
+#define __RFID_QUEUE__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mfrc522.h"
+
+
+//! Capacity in events, power of 2, at most 128 on AVR.
+#ifndef MFRC522_QUEUE_SIZE
+#ifdef __AVR__
+#define MFRC522_QUEUE_SIZE	8
+#else
+#define MFRC522_QUEUE_SIZE	32
+#endif
+#endif
+
+
+//! \brief Queued card event.
+typedef struct CardEvent {
+	UID_t uid; //!< Card of the event.
+	uint32_t time; //!< Tick of the push, see mfrc522_queueInit().
+	uint8_t event; //!< PresenceEvent_t.
+} CardEvent_t;
+
+
+//! \brief Empty the queue and clear the overflow counter.
+//!
+//! Neither producer nor consumer may run meanwhile.
+//!
+//! \param now Function returning a free-running tick counter, NULL for no timestamp.
+//! \return none.
+//!
+void mfrc522_queueInit(uint32_t (*now)(void));
+
+
+//! \brief Push one event, producer side.
+//! \param event PresenceEvent_t of the card.
+//! \param [in] uid Card of the event, copied.
+//! \return true if queued, false if the queue was full.
+//!
+bool mfrc522_queuePush(PresenceEvent_t event, const UID_t *uid);
+
+
+//! \brief Push one event, CardCallback_t of mfrc522_events.h.
+//! \param event PresenceEvent_t of the card.
+//! \param [in] uid Card of the event.
+//! \param context Unused.
+//! \return none.
+//!
+void mfrc522_queueCallback(PresenceEvent_t event, const UID_t *uid, void *context);
+
+
+//! \brief Pop up to \p max events, consumer side.
+//! \param [out] events Array of at least \p max CardEvent_t, oldest first.
+//! \param max Maximum number of events.
+//! \return Number of events copied.
+//!
+uint8_t mfrc522_queueDrain(CardEvent_t *events, uint8_t max);
+
+
+//! \brief Get number of events dropped because the queue was full.
+//! \return Overflow counter, it wraps around.
+//!
+uint32_t mfrc522_queueOverflows(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_QUEUE__ */
+
+/**************************** End of File ************************************/
@@ -23,14 +23,17 @@
 #define MFRC522_CMD_TRANSCEIVE    0x0C               
 #define MFRC522_CMD_SOFTRESET     0x0F               
 #define MFRC522_CMD_CALCCRC       0x03               
+#define MFRC522_CMD_MEM           0x01
 
 // MIFARE Comaand set
 #define MIFARE_CMD_REQA           0x26              
 #define MIFARE_CMD_WUPA           0x52         
 #define MIFARE_CMD_ANTICOLLCL1    0x93   
 #define MIFARE_CMD_ANTICOLLCL2    0x95
+#define MIFARE_CMD_ANTICOLLCL3    0x97
 #define MIFARE_CMD_SELECTCL1      0x93            
 #define MIFARE_CMD_SELECTCL2      0x95
+#define MIFARE_CMD_SELECTCL3      0x97
 #define MIFARE_CMD_AUTHENT1A      0x60            
 #define MIFARE_CMD_AUTHENT1B      0x61            
 #define MIFARE_CMD_READ           0x30              
@@ -75,7 +78,7 @@
 #define Reserved11            0x1A
 #define Reserved12            0x1B
 #define MifareReg             0x1C
-#define Reserved13            0x1D
+#define MfRxReg               0x1D
 #define Reserved14            0x1E
 #define SerialSpeedReg        0x1F
 
@@ -0,0 +1,91 @@
+
+//! \file mfrc522_replay.h
+//! \brief Replay of MFRC522 traces against the driver on a Linux host.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! The replay device is a device of the host-side SPI bus (see spi_host.h) that
+//! answers register reads with the values recorded in a trace (mfrc522_trace.h),
+//! so the unmodified driver re-runs a session recorded at a site.
+//! Every access of the driver is checked against the recorded one.
+//!
+//! Busy-wait polls are replayed by time: a recorded run of identical reads
+//! keeps its value until the virtual time (utils_host.h) recorded for the run
+//! has elapsed, so a driver polling less often sees the same response times.
+//!
+//! On a mismatch, the replay looks ahead for the access of the driver
+//! (recorded accesses skipped are missing), otherwise answers with the last
+//! recorded value of the register (the access is extra).
+
+
+#ifndef __RFID_REPLAY__
+#define __RFID_REPLAY__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spi_host.h"
+#include "mfrc522_trace.h"
+
+
+//! \brief Result of a replay.
+typedef struct ReplayReport {
+	uint32_t accesses; //!< Register accesses of the driver, FIFO bytes included.
+	uint32_t frames; //!< SPI frames of the driver.
+	uint32_t recordedAccesses; //!< Register accesses in the trace.
+	uint32_t recordedFrames; //!< SPI frames in the trace, a FIFO burst is one frame.
+	uint64_t recordedTime_ns; //!< Time span of the trace.
+	uint32_t divergences; //!< Accesses that differ from the trace.
+	uint32_t missing; //!< Recorded accesses the driver skipped.
+	uint32_t extra; //!< Accesses of the driver that are not in the trace.
+	bool complete; //!< The whole trace was consumed.
+
+	// First divergence
+	uint32_t firstAccess; //!< Index of access of the driver, UINT32_MAX if none.
+	uint32_t firstCommand; //!< Number of recorded command it happened in, from 1, 0 if outside.
+	uint8_t expectedTag; //!< Recorded TRACE_READ/TRACE_WRITE | register, TRACE_END if trace ended.
+	uint8_t expectedValue; //!< Recorded value.
+	uint8_t actualTag; //!< Access of the driver.
+	uint8_t actualValue; //!< Value written by the driver, or answered.
+} ReplayReport_t;
+
+
+//! \brief Get SPI device of the replay, to be passed to host_mfrc522_init().
+//! Until a trace is loaded, every register reads 0x00.
+//! \return pointer to SPIDevice_t instance.
+//!
+const SPIDevice_t* mfrc522_replay_device(void);
+
+
+//! \brief Load a trace and start replaying it, the report is cleared.
+//! \param [in] events Drained trace, copied.
+//! \param count Number of events.
+//! \param nsPerTick Clock unit of timestamps, in nanosecond.
+//! \return true if success, false if out of memory.
+//!
+bool mfrc522_replay_load(const TraceEvent_t *events, uint32_t count, uint32_t nsPerTick);
+
+
+//! \brief Check if the whole trace has been replayed.
+//! \return true if finished.
+//!
+bool mfrc522_replay_finished(void);
+
+
+//! \brief Get result of the replay.
+//! \param [out] report Pointer to ReplayReport_t instance.
+//! \return none.
+//!
+void mfrc522_replay_getReport(ReplayReport_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_REPLAY__ */
+
+/**************************** End of File ************************************/
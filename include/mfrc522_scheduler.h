@@ -0,0 +1,85 @@
+
+//! \file mfrc522_scheduler.h
+//! \brief Adaptive polling scheduler of MFRC522 reader
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! mfrc522_schedulerAvailable() replaces a fixed-rate mfrc522_available() loop:
+//! REQA is only sent when a poll is due, the interval is adapted from the
+//! recent arrival history.
+//!
+//! - After a card was seen, the field is polled at the minimum interval for a burst time.
+//! - While the field is idle, the interval doubles at every poll,
+//!   up to the maximum interval (latency ceiling).
+//! - The back-off is also capped at a quarter of the mean time between arrivals
+//!   (or of the time since the last arrival, if longer), so it stays short while
+//!   cards keep coming (shift change) and reaches the ceiling only when arrivals are rare.
+
+
+#ifndef __RFID_SCHEDULER__
+#define __RFID_SCHEDULER__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//! \brief Limits of the poll interval, in ticks of the clock source.
+typedef struct SchedulerConfig {
+	uint32_t minInterval; //!< Interval of a burst, the fastest polling.
+	uint32_t maxInterval; //!< Interval of an idle field, latency ceiling.
+	uint32_t burst; //!< Time polled at minInterval after a card was seen.
+} SchedulerConfig_t;
+
+
+//! \brief Configure the scheduler, the field is considered idle.
+//! \param [in] config Interval limits, copied.
+//! \param now Function returning a free-running tick counter, e.g. micros().
+//! \return none.
+//!
+void mfrc522_schedulerInit(const SchedulerConfig_t *config, uint32_t (*now)(void));
+
+
+//! \brief Poll the field if a poll is due.
+//!
+//! Call it from the main loop as often as wanted, no SPI access is done
+//! between polls. The reader may be in low-power mode, see mfrc522_setLowPower().
+//!
+//! \return true if a new card is available, see mfrc522_available().
+//!
+bool mfrc522_schedulerAvailable();
+
+
+//! \brief Get time left until next poll, e.g. to sleep the MCU.
+//! \return Ticks, 0 if a poll is due.
+//!
+uint32_t mfrc522_schedulerWait();
+
+
+//! \brief Get current poll interval.
+//! \return Ticks.
+//!
+uint32_t mfrc522_schedulerInterval();
+
+
+//! \brief Get expected detection latency of a card arriving now.
+//!
+//! A card arrives at a random time of the interval: the expected latency
+//! is half the interval plus the duration of the last poll,
+//! the worst case is the whole interval plus the duration of the last poll.
+//!
+//! \param worst Return the worst case instead of the expected one.
+//! \return Ticks.
+//!
+uint32_t mfrc522_schedulerLatency(bool worst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_SCHEDULER__ */
+
+/**************************** End of File ************************************/
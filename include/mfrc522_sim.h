@@ -0,0 +1,172 @@
+
+//! \file mfrc522_sim.h
+//! \brief Register-level simulator of MFRC522 reader with virtual ISO 14443A cards.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! The simulator is a device of the host-side SPI bus (see spi_host.h),
+//! so the unmodified driver runs on a Linux host. It models the register file,
+//! the 64-byte FIFO, ComIrqReg/DivIrqReg/ErrorReg/CollReg, the timer,
+//! the CRC coprocessor and a field of virtual cards.
+//! Time is virtual (utils_host.h): SPI bytes, delays and air frames advance it.
+
+
+#ifndef __RFID_SIM__
+#define __RFID_SIM__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spi_host.h"
+
+
+//! Maximum number of cards in the field at the same time.
+#define SIM_MAX_CARDS	8
+
+//! Number of simulated readers, see mfrc522_sim_useReader().
+#define SIM_MAX_READERS	4
+
+
+//! \brief Type of virtual card.
+typedef enum SimCardType {
+	SIM_CARD_CLASSIC_1K, //!< MIFARE Classic 1K, 64 blocks, SAK 0x08.
+	SIM_CARD_ULTRALIGHT //!< MIFARE Ultralight, 16 pages, SAK 0x00.
+} SimCardType_t;
+
+
+//! \brief Virtual ISO 14443A card, created by mfrc522_sim_createCard().
+typedef struct SimCard {
+	uint8_t uid[10]; //!< UID, 4, 7 or 10 bytes.
+	uint8_t size; //!< UID size.
+	SimCardType_t type; //!< Card type.
+	uint8_t memory[1024]; //!< Blocks (Classic) or pages (Ultralight).
+
+	// Internal state, do not modify.
+	uint8_t state;
+	uint8_t level;
+	bool halted;
+	int8_t authSector;
+	int16_t writeBlock;
+} SimCard_t;
+
+
+//! \brief Counters of the simulator.
+typedef struct SimStats {
+	uint32_t regReads; //!< Register reads, FIFO bytes included.
+	uint32_t regWrites; //!< Register writes, FIFO bytes included.
+	uint32_t frames; //!< Frames sent by the reader over the air.
+	uint32_t responses; //!< Frames answered by at least one card.
+	uint32_t collisions; //!< Responses with bit collision.
+	uint32_t timeouts; //!< Timer expirations.
+	uint32_t corrupted; //!< Frames corrupted by mfrc522_sim_setNoise().
+	uint64_t air_ns; //!< Air time of all frames and responses, FDT included.
+} SimStats_t;
+
+
+//! \brief Power-on reset of the simulated reader, its field is emptied.
+//! \return none.
+//!
+void mfrc522_sim_init(void);
+
+
+//! \brief Get SPI device of the simulator, to be passed to host_mfrc522_init().
+//! \return pointer to SPIDevice_t instance.
+//!
+const SPIDevice_t* mfrc522_sim_device(void);
+
+
+//! \brief Apply the following calls to another simulated reader, reader 0 by default.
+//!
+//! Every reader has its own registers, field of cards, noise, coupling and
+//! counters, and its own SPI device returned by mfrc522_sim_device().
+//! Time is shared: commands run on all readers at once. Call
+//! mfrc522_sim_init() once per reader.
+//!
+//! \param reader 0 to SIM_MAX_READERS - 1, others are ignored.
+//! \return none.
+//!
+void mfrc522_sim_useReader(uint8_t reader);
+
+
+//! \brief Create a virtual card with factory content (transport keys FF..FF).
+//! \param [out] card Pointer to SimCard_t instance.
+//! \param type Card type.
+//! \param [in] uid UID of the card.
+//! \param size 4, 7 or 10.
+//! \return none.
+//!
+void mfrc522_sim_createCard(SimCard_t *card, SimCardType_t type, const uint8_t *uid, uint8_t size);
+
+
+//! \brief Put a card into the field. It starts in IDLE state.
+//! \param [in] card Pointer to SimCard_t instance, must stay valid while in the field.
+//! \return true if success, false if the field is full.
+//!
+bool mfrc522_sim_addCard(SimCard_t *card);
+
+
+//! \brief Take a card out of the field.
+//! \param [in] card Pointer to SimCard_t instance.
+//! \return none.
+//!
+void mfrc522_sim_removeCard(SimCard_t *card);
+
+
+//! \brief Take all cards out of the field.
+//! \return none.
+//!
+void mfrc522_sim_clearField(void);
+
+
+//! \brief Corrupt frames on air, as on a reader mounted on metal.
+//!
+//! A corrupted frame from the reader is seen as an error by the cards, which
+//! go back to IDLE (or HALT) state and do not answer. A corrupted answer has
+//! a parity error. Corruption is pseudo-random and reproducible.
+//!
+//! \param permille Corrupted frames per 1000, in each direction, 0 to disable.
+//! \return none.
+//!
+void mfrc522_sim_setNoise(uint16_t permille);
+
+
+//! \brief Set the coupling of cards to the antenna, as by distance or metal nearby.
+//!
+//! The field at the cards grows with the conductance of the TX drivers
+//! (CWGsPReg, GsNReg) and the coupling, and must be strong enough to power
+//! them. Their answer is amplified by RxGain (RFCfgReg) and must reach MinLevel
+//! (RxThresholdReg) to be seen, and is clipped if too strong. Frames from the
+//! reader are corrupted more often in a weak field, answers more often with a
+//! high gain and a low MinLevel, see mfrc522_sim_setNoise(). A card at 50%
+//! is not seen with the reset configuration.
+//!
+//! \param percent Coupling, 100 by default: nominal range of the reset configuration.
+//! \return none.
+//!
+void mfrc522_sim_setCoupling(uint16_t percent);
+
+
+//! \brief Read a register without side effects.
+//! \param reg Register address.
+//! \return register value.
+//!
+uint8_t mfrc522_sim_peek(uint8_t reg);
+
+
+//! \brief Get and reset counters of the simulator.
+//! \return none.
+//!
+void mfrc522_sim_getStats(SimStats_t *stats);
+void mfrc522_sim_resetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_SIM__ */
+
+/**************************** End of File ************************************/
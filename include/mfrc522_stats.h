@@ -0,0 +1,147 @@
+
+//! \file mfrc522_stats.h
+//! \brief Runtime latency and error counters of MFRC522 driver.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Every command executed by the reader is classified by the frame it sends
+//! (REQA/WUPA, ANTICOLLISION, SELECT, ...) and counted by result status,
+//! busy-wait iterations and latency.
+//! Latency is measured with a clock source given to mfrc522_statsInit():
+//! micros() of utils_tiva.h on Tiva, virtual micros() of utils_host.h on host,
+//! a free-running timer (e.g. TCNT1) on AVR.
+//!
+//! Time spent awake and in soft power-down (mfrc522_powerDown()) is counted too,
+//! with the wake-up latency, so the energy cost of a polling scheme can be
+//! weighed against its detection latency, see mfrc522_statsAverageCurrent().
+//!
+//! The counters only exist if MFRC522_STATS is defined when building the library,
+//! otherwise the hooks compile to nothing.
+
+
+#ifndef __RFID_STATS__
+#define __RFID_STATS__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "mfrc522_status.h"
+
+
+//! Number of latency buckets, bucket i counts latencies in [2^i, 2^(i+1)) ticks,
+//! bucket 0 also counts 0 tick and the last bucket everything above.
+#ifndef MFRC522_STATS_BUCKETS
+#define MFRC522_STATS_BUCKETS	12
+#endif
+
+//! Status codes returned by reader commands, STATUS_OK to STATUS_MIFARE_NACK,
+//! then STATUS_HUNG, counted at MFRC522_STATS_HUNG.
+#define MFRC522_STATS_HUNG		(STATUS_MIFARE_NACK + 1)
+#define MFRC522_STATS_STATUS	(MFRC522_STATS_HUNG + 1)
+
+
+//! Counters are 16-bit on AVR to save RAM, they wrap around.
+#ifdef __AVR__
+typedef uint16_t StatsCounter_t;
+#else
+typedef uint32_t StatsCounter_t;
+#endif
+
+
+//! \brief Frame types the counters are kept for.
+typedef enum StatsFrame {
+	STATS_REQUEST, //!< REQA or WUPA.
+	STATS_ANTICOLL, //!< ANTICOLLISION of any cascade level.
+	STATS_SELECT, //!< SELECT of any cascade level.
+	STATS_HALT, //!< HLTA.
+	STATS_AUTH, //!< MFAuthent command.
+	STATS_READ, //!< MIFARE READ.
+	STATS_WRITE, //!< MIFARE WRITE, both command and data frames.
+	STATS_CRC, //!< CRC coprocessor.
+	STATS_OTHER, //!< Anything else.
+	STATS_FRAMES
+} StatsFrame_t;
+
+
+//! \brief Counters of one frame type.
+typedef struct FrameStats {
+	StatsCounter_t status[MFRC522_STATS_STATUS]; //!< Commands by returned status.
+	StatsCounter_t polls; //!< Busy-wait iterations.
+	StatsCounter_t latency[MFRC522_STATS_BUCKETS]; //!< log2 histogram, in clock ticks.
+} FrameStats_t;
+
+
+//! \brief Power-down counters, times in clock ticks.
+typedef struct PowerStats {
+	StatsCounter_t wakeups; //!< Wake-ups from soft power-down.
+	StatsCounter_t latency[MFRC522_STATS_BUCKETS]; //!< Wake-up latency, log2 histogram.
+	uint32_t maxLatency; //!< Longest wake-up.
+	uint32_t awake; //!< Time with oscillator running.
+	uint32_t asleep; //!< Time in soft power-down.
+	uint32_t maxAsleep; //!< Longest soft power-down.
+} PowerStats_t;
+
+
+//! \brief Counters of MFRC522 driver.
+typedef struct RFIDStats {
+	FrameStats_t frame[STATS_FRAMES]; //!< Indexed by StatsFrame_t.
+	PowerStats_t power; //!< Awake and power-down times.
+} RFIDStats_t;
+
+
+#ifdef MFRC522_STATS
+
+//! \brief Set clock source and reset the counters.
+//! \param now Function returning a free-running tick counter, any unit.
+//! Pass NULL to count status and polls only.
+//! \return none.
+//!
+void mfrc522_statsInit(uint32_t (*now)(void));
+
+
+//! \brief Copy the counters, awake or power-down time is counted up to now.
+//! \param [out] stats Pointer to RFIDStats_t instance.
+//! \return none.
+//!
+void mfrc522_statsSnapshot(RFIDStats_t *stats);
+
+
+//! \brief Clear the counters.
+//! \return none.
+//!
+void mfrc522_statsReset(void);
+
+
+//! \brief Estimate average supply current of the reader.
+//!
+//! Typical figures of MFRC522 datasheet ch. 14: about 10uA in soft power-down,
+//! 10mA + antenna driver current (60mA, depends on antenna matching) awake.
+//!
+//! \param [in] stats Counters from mfrc522_statsSnapshot().
+//! \param awakeCurrent Supply current with field on, in uA.
+//! \param asleepCurrent Supply current in soft power-down, in uA.
+//! \return Average current in uA, weighted by awake and power-down times.
+//!
+uint32_t mfrc522_statsAverageCurrent(const RFIDStats_t *stats,
+										uint32_t awakeCurrent, uint32_t asleepCurrent);
+
+
+// Hooks called by the driver.
+uint32_t mfrc522_statsNow(void);
+void mfrc522_statsRecord(uint8_t command, const void *txBuffer, uint8_t txSize,
+							uint8_t status, uint16_t polls, uint32_t start);
+void mfrc522_statsSleep(void);
+void mfrc522_statsWake(uint32_t start);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_STATS__ */
+
+/**************************** End of File ************************************/
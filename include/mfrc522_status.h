@@ -21,5 +21,6 @@
 #define	STATUS_CHANGE_OK		0x0C
 #define	STATUS_TRANSFER_OK		0x0D
 #define	STATUS_STORE_OK			0x0E
+#define	STATUS_HUNG				0x0F // reader missed the MCU-side deadline, recovered
 
 /**************************** End of File ************************************/
\ No newline at end of file
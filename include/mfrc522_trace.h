@@ -0,0 +1,108 @@
+
+//! \file mfrc522_trace.h
+//! \brief Binary trace of MFRC522 register accesses and commands.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Every register read/write (FIFO bytes included) and every command begin/end
+//! is stored as a 4-byte event in a ring buffer, without allocation.
+//! The driver is the only producer, one consumer drains the ring with
+//! mfrc522_traceRead() between driver calls, from the context the driver runs
+//! in (e.g. the main loop), without locking.
+//! When the ring is full new events are dropped and counted.
+//! Identical consecutive reads (busy-wait polls) are stored once, followed by
+//! a TRACE_REPEAT event.
+//!
+//! Drained events written as they are to a file are decoded on host by
+//! the mfrc522_trace tool into an ISO 14443A protocol log.
+//!
+//! The trace only exists if MFRC522_TRACE is defined when building the library.
+
+
+#ifndef __RFID_TRACE__
+#define __RFID_TRACE__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+//! Number of events in the ring, power of 2.
+#ifndef MFRC522_TRACE_SIZE
+#ifdef __AVR__
+#define MFRC522_TRACE_SIZE	64
+#else
+#define MFRC522_TRACE_SIZE	1024
+#endif
+#endif
+
+
+//! Event tags: type in bit 7-6, register address in bit 5-0.
+#define TRACE_TYPE		0xC0
+#define TRACE_WRITE		0x00 //!< value = written byte
+#define TRACE_READ		0x40 //!< value = read byte
+#define TRACE_BEGIN		0xC0 //!< | command, value = tx size
+#define TRACE_END		0xD0 //!< | command, value = status
+#define TRACE_REPEAT	0xE0 //!< previous read repeated value times
+
+
+//! \brief Trace event, little-endian on every supported MCU.
+typedef struct TraceEvent {
+	uint16_t time; //!< Low 16 bits of clock ticks.
+	uint8_t tag; //!< TRACE_* and register address or command.
+	uint8_t value; //!< Data byte, size, status or count.
+} TraceEvent_t;
+
+
+#ifdef MFRC522_TRACE
+
+//! \brief Set clock source, clear the ring and start tracing.
+//! \param now Function returning a free-running tick counter, see mfrc522_stats.h.
+//! The 16-bit timestamps must not wrap between two events, i.e. ticks of 1us
+//! are fine since the driver polls the reader continuously while waiting.
+//! Pass NULL to trace without time.
+//! \return none.
+//!
+void mfrc522_traceInit(uint32_t (*now)(void));
+
+
+//! \brief Pause or resume tracing.
+//! \param enable true to record events.
+//! \return none.
+//!
+void mfrc522_traceEnable(bool enable);
+
+
+//! \brief Take the oldest events out of the ring.
+//!
+//! The count of identical reads still pending is pushed first, so the last
+//! busy-wait is complete. This is why it must not interrupt the driver.
+//!
+//! \param [out] events Buffer of TraceEvent_t.
+//! \param max Size of buffer, in events.
+//! \return number of events copied.
+//!
+uint16_t mfrc522_traceRead(TraceEvent_t *events, uint16_t max);
+
+
+//! \brief Number of events dropped since mfrc522_traceInit() because the ring was full.
+//! \return number of events.
+//!
+uint16_t mfrc522_traceDropped(void);
+
+
+// Hook called by the driver.
+void mfrc522_traceEvent(uint8_t tag, uint8_t value);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RFID_TRACE__ */
+
+/**************************** End of File ************************************/
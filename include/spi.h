@@ -63,6 +63,18 @@ void tiva_spi_master_init(uint32_t base,
 void tiva_spi_slave_init(uint32_t base, uint32_t data_mode, uint8_t data_width);
 
 
+/**
+ * @brief Send the following transfers to another SSI module of Tiva C.
+ *
+ * Every module keeps the configuration of its init function, so devices
+ * on several modules are switched without reconfiguring them.
+ *
+ * @param base Memory base of Tiva C SSI module, already initialized.
+ * @return nothing.
+ */
+void tiva_spi_use(uint32_t base);
+
+
 
 /**
  * @brief Set bit order for SPI transferting.
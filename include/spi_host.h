@@ -0,0 +1,118 @@
+/** 
+ * @file spi_host.h
+ * @brief SPI bus for Linux host, bytes are passed to an attached device.
+ * @author Nguyen Trong Phuong (aka trongphuongpro)
+ * @date 2026 Oct 18
+ *
+ * The generic spi_*() functions of spi.h are implemented on top of it.
+ */
+
+#ifndef __SPI_HOST__
+#define __SPI_HOST__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spi.h"
+
+
+/**
+ * @brief Slave device attached to the host-side SPI bus.
+ *
+ * Used to run the drivers on a Linux host against a simulator
+ * or a recorded trace instead of real hardware.
+ */
+typedef struct SPIDevice {
+    void (*select)(void *context, bool selected); //!< SS pin changed.
+    uint8_t (*transfer)(void *context, uint8_t data); //!< 1-byte full-duplex transfer.
+    void (*reset)(void *context); //!< RST pin pulsed, may be NULL.
+    void *context; //!< Passed to every callback.
+} SPIDevice_t;
+
+
+/**
+ * @brief Counters of the host-side SPI bus.
+ */
+typedef struct SPIStats {
+    uint32_t frames; //!< Number of SS assertions.
+    uint32_t bytes; //!< Number of transferred bytes.
+    uint64_t time_ns; //!< Bus time at the configured clock.
+} SPIStats_t;
+
+
+/**
+ * @brief Initialize host-side SPI bus.
+ *
+ * @param device Device attached to the bus.
+ * @param speed Simulated SPI clock, in Hz.
+ * @return nothing.
+ */
+void host_spi_master_init(const SPIDevice_t *device, uint32_t speed);
+
+
+/**
+ * @brief Attach another device to the host-side SPI bus, as another SS pin.
+ *
+ * Clock, wiring limit and counters are kept.
+ *
+ * @param device Device attached to the bus.
+ * @return nothing.
+ */
+void host_spi_setDevice(const SPIDevice_t *device);
+
+
+/**
+ * @brief Change and get the clock of the host-side SPI bus.
+ * @param speed Simulated SPI clock, in Hz.
+ * @return clock in Hz, for host_spi_getClock().
+ */
+void host_spi_setClock(uint32_t speed);
+uint32_t host_spi_getClock(void);
+
+
+/**
+ * @brief Limit the clock of the wiring, as long or unshielded wires.
+ *
+ * Above the limit, received bytes get a bit flipped now and then, the more
+ * often the faster the clock. Reproducible.
+ *
+ * @param speed Fastest reliable clock, in Hz, 0 for no limit (default).
+ * @return nothing.
+ */
+void host_spi_setLimit(uint32_t speed);
+
+
+/**
+ * @brief Drive SS pin of the host-side SPI bus.
+ * @param selected true to pull SS LOW.
+ * @return nothing.
+ */
+void host_spi_select(bool selected);
+
+
+/**
+ * @brief Pulse RST pin of the device attached to host-side SPI bus.
+ * @return nothing.
+ */
+void host_spi_reset(void);
+
+
+/**
+ * @brief Get and reset counters of the host-side SPI bus.
+ * @return nothing.
+ */
+void host_spi_getStats(SPIStats_t *stats);
+void host_spi_resetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPI_HOST__ */
+
+/**************************** End of File ************************************/
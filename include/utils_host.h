@@ -0,0 +1,54 @@
+//! \file utils_host.h
+//! \brief Utility functions for Linux host, used by simulation.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+#ifndef __UTILS_HOST__
+#define __UTILS_HOST__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+
+//! \brief Delay in millisecond, only advances virtual clock.
+//! \param ms millisecond.
+//! \return nothing.
+//!
+void delay_ms(uint16_t ms);
+
+
+//! \brief Delay in microsecond, only advances virtual clock.
+//! \param us microsecond.
+//! \return nothing.
+//!
+void delay_us(uint16_t us);
+
+
+//! \brief Get virtual clock.
+//! \return time in nanosecond since start.
+//!
+uint64_t host_time_ns(void);
+
+
+//! \brief Get virtual clock, as clock source of mfrc522_statsInit().
+//! \return time in microsecond, wraps after ~71 minutes.
+//!
+uint32_t micros(void);
+
+
+//! \brief Advance virtual clock, called by SPI bus and delays.
+//! \param ns nanosecond.
+//! \return nothing.
+//!
+void host_time_advance(uint64_t ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/********************* End of File *******************************************/
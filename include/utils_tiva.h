@@ -32,6 +32,12 @@ void delay_init();
 //!
 void delay_ms(uint16_t ms);
 
+
+//! \brief Get time since delay_init(), from SysTick.
+//! \return time in microsecond, wraps after ~71 minutes.
+//!
+uint32_t micros();
+
 #ifdef __cplusplus
 }
 #endif
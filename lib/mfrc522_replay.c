@@ -0,0 +1,317 @@
+
+//! \file mfrc522_replay.c
+//! \brief Replay of MFRC522 traces against the driver on a Linux host.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_replay.h"
+#include "mfrc522_registers.h"
+#include "utils_host.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+// Recorded accesses searched for the access of the driver after a mismatch
+#define LOOKAHEAD	256
+
+
+// Consecutive identical accesses of the trace
+typedef struct Run {
+	uint8_t tag; // TRACE_READ or TRACE_WRITE | register
+	uint8_t value;
+	uint32_t count;
+	uint64_t start_ns; // recorded time of first and last access
+	uint64_t end_ns;
+	uint32_t command; // recorded command number, 0 if outside
+} Run_t;
+
+
+static Run_t *runs;
+static uint32_t runCount;
+static uint32_t position; // current run
+static uint32_t consumed; // accesses of current run already replayed
+static uint64_t runStart_ns; // virtual time of first access of current run
+static uint8_t recorded[64]; // last recorded value of each register
+static ReplayReport_t report;
+
+// SPI frame decoder
+static bool firstByte;
+static bool reading;
+static uint8_t address;
+
+static void replay_select(void *context, bool selected);
+static uint8_t replay_transfer(void *context, uint8_t data);
+
+static const SPIDevice_t device = {
+	.select = replay_select,
+	.transfer = replay_transfer,
+	.reset = NULL,
+	.context = NULL
+};
+
+static bool replay_timed(const Run_t *run);
+static uint8_t replay_access(uint8_t tag, uint8_t value);
+static uint8_t replay_consume(uint8_t value);
+static void replay_advance(void);
+static void replay_diverge(uint8_t expectedTag, uint8_t expectedValue, uint8_t tag, uint8_t value);
+
+
+const SPIDevice_t* mfrc522_replay_device(void) {
+	return &device;
+}
+
+
+bool mfrc522_replay_load(const TraceEvent_t *events, uint32_t count, uint32_t nsPerTick) {
+	free(runs);
+	runs = malloc((count ? count : 1) * sizeof(Run_t));
+
+	if (runs == NULL) {
+		return false;
+	}
+
+	memset(&report, 0, sizeof(report));
+	memset(recorded, 0, sizeof(recorded));
+	report.firstAccess = UINT32_MAX;
+	runCount = 0;
+	position = 0;
+	consumed = 0;
+
+	uint64_t time = 0;
+	uint64_t first = 0;
+	uint16_t last = count ? events[0].time : 0;
+	uint32_t command = 0;
+	uint32_t current = 0;
+	uint8_t depth = 0;
+
+	for (uint32_t i = 0; i < count; i++) {
+		const TraceEvent_t *event = &events[i];
+		Run_t *previous = runCount ? &runs[runCount - 1] : NULL;
+
+		// unwrap 16-bit timestamps
+		time += (uint16_t)(event->time - last) * (uint64_t)nsPerTick;
+		last = event->time;
+
+		if (i == 0) {
+			first = time;
+		}
+
+		if ((event->tag & 0xF0) == TRACE_BEGIN) {
+			// CRC check of received frame is nested in its command
+			if (depth++ == 0) {
+				current = ++command;
+			}
+			continue;
+		}
+
+		if ((event->tag & 0xF0) == TRACE_END) {
+			if (depth && --depth == 0) {
+				current = 0;
+			}
+			continue;
+		}
+
+		if (event->tag == TRACE_REPEAT) {
+			if (previous && (previous->tag & TRACE_TYPE) == TRACE_READ) {
+				previous->count += event->value;
+				previous->end_ns = time;
+				report.recordedAccesses += event->value;
+
+				if ((previous->tag & 0x3F) != FIFODataReg) {
+					report.recordedFrames += event->value;
+				}
+			}
+			continue;
+		}
+
+		uint8_t reg = event->tag & 0x3F;
+		bool fifo = (reg == FIFODataReg);
+
+		report.recordedAccesses++;
+
+		// FIFO bytes of one burst are one frame
+		if (!fifo || previous == NULL || previous->tag != event->tag) {
+			report.recordedFrames++;
+		}
+
+		Run_t *run = &runs[runCount++];
+
+		run->tag = event->tag;
+		run->value = event->value;
+		run->count = 1;
+		run->start_ns = time;
+		run->end_ns = time;
+		run->command = current;
+	}
+
+	report.recordedTime_ns = time - first;
+	return true;
+}
+
+
+bool mfrc522_replay_finished(void) {
+	// The last run is consumed once it is read, if timed
+	if (position + 1 == runCount && consumed && replay_timed(&runs[position])) {
+		return true;
+	}
+
+	return position >= runCount;
+}
+
+
+void mfrc522_replay_getReport(ReplayReport_t *__report) {
+	report.complete = mfrc522_replay_finished();
+	memcpy(__report, &report, sizeof(report));
+}
+
+/**************************** SPI device *************************************/
+
+void replay_select(void *context, bool selected) {
+	(void)context;
+
+	if (selected) {
+		firstByte = true;
+		report.frames++;
+	}
+}
+
+
+uint8_t replay_transfer(void *context, uint8_t data) {
+	(void)context;
+
+	// Address byte: MSB = 1 is Read, bit 6-1 is Address.
+	if (firstByte) {
+		firstByte = false;
+		reading = data & 0x80;
+		address = (data >> 1) & 0x3F;
+		return 0;
+	}
+
+	if (reading) {
+		// Every byte sent during a read is the next address.
+		uint8_t value = replay_access(TRACE_READ | address, 0);
+		address = (data >> 1) & 0x3F;
+		return value;
+	}
+
+	replay_access(TRACE_WRITE | address, data);
+	return 0;
+}
+
+/**************************** Helper functions *******************************/
+
+uint8_t replay_access(uint8_t tag, uint8_t value) {
+	bool read = (tag & TRACE_TYPE) == TRACE_READ;
+
+	// Nothing loaded yet: let the driver initialize
+	if (runs == NULL) {
+		return 0;
+	}
+
+	report.accesses++;
+
+	// Polled register keeps its value as long as it was recorded
+	if (position < runCount && consumed && replay_timed(&runs[position])) {
+		const Run_t *run = &runs[position];
+
+		if (host_time_ns() - runStart_ns >= run->end_ns - run->start_ns) {
+			replay_advance();
+		}
+	}
+
+	if (position < runCount && runs[position].tag == tag) {
+		return replay_consume(value);
+	}
+
+	// Look ahead for the access, recorded ones in between are missing
+	for (uint32_t i = position + 1; i < runCount && i <= position + LOOKAHEAD; i++) {
+		if (runs[i].tag != tag) {
+			continue;
+		}
+
+		replay_diverge(runs[position].tag, runs[position].value, tag, read ? runs[i].value : value);
+
+		while (position < i) {
+			if (consumed < runs[position].count) {
+				report.missing += runs[position].count - consumed;
+			}
+
+			replay_advance();
+		}
+
+		return replay_consume(value);
+	}
+
+	// Not in the trace
+	uint8_t answer = read ? recorded[tag & 0x3F] : value;
+
+	if (position < runCount) {
+		replay_diverge(runs[position].tag, runs[position].value, tag, answer);
+	}
+	else {
+		replay_diverge(TRACE_END, 0, tag, answer);
+	}
+
+	report.extra++;
+
+	return read ? answer : 0;
+}
+
+
+uint8_t replay_consume(uint8_t value) {
+	const Run_t *run = &runs[position];
+	bool read = (run->tag & TRACE_TYPE) == TRACE_READ;
+
+	if (consumed++ == 0) {
+		runStart_ns = host_time_ns();
+	}
+
+	if (!read && value != run->value) {
+		replay_diverge(run->tag, run->value, run->tag, value);
+	}
+
+	uint8_t answer = run->value;
+
+	// Timed runs are left by the next access, see replay_access()
+	if (!replay_timed(run) && consumed >= run->count) {
+		replay_advance();
+	}
+
+	return read ? answer : 0;
+}
+
+
+bool replay_timed(const Run_t *run) {
+	return ((run->tag & TRACE_TYPE) == TRACE_READ) && ((run->tag & 0x3F) != FIFODataReg);
+}
+
+
+void replay_advance(void) {
+	const Run_t *run = &runs[position];
+
+	if ((run->tag & TRACE_TYPE) == TRACE_READ) {
+		recorded[run->tag & 0x3F] = run->value;
+	}
+
+	position++;
+	consumed = 0;
+}
+
+
+void replay_diverge(uint8_t expectedTag, uint8_t expectedValue, uint8_t tag, uint8_t value) {
+	report.divergences++;
+
+	if (report.firstAccess != UINT32_MAX) {
+		return;
+	}
+
+	report.firstAccess = report.accesses - 1;
+	report.firstCommand = (position < runCount) ? runs[position].command : 0;
+	report.expectedTag = expectedTag;
+	report.expectedValue = expectedValue;
+	report.actualTag = tag;
+	report.actualValue = value;
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,1283 @@
+
+//! \file mfrc522_sim.c
+//! \brief Register-level simulator of MFRC522 reader with virtual ISO 14443A cards.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_sim.h"
+#include "mfrc522_registers.h"
+#include "utils_host.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+#define FC_HZ			13560000ULL
+#define ETU_NS			9440 // 128/fc, one bit at 106 kbit/s
+#define FDT_NS			86430 // 1172/fc, frame delay time card -> reader
+#define CRC_NS			590 // 8/fc per byte
+#define SOFTRESET_NS	40000
+#define HARDRESET_NS	1000000
+
+// ComIrqReg bits
+#define IRQ_TX		BIT_6
+#define IRQ_RX		BIT_5
+#define IRQ_IDLE	BIT_4
+#define IRQ_ERR		BIT_1
+#define IRQ_TIMER	BIT_0
+
+// DivIrqReg bits
+#define IRQ_CRC		BIT_2
+
+// ErrorReg bits
+#define ERR_PROTOCOL	BIT_0
+#define ERR_PARITY		BIT_1
+#define ERR_CRC			BIT_2
+#define ERR_COLL		BIT_3
+#define ERR_BUFFER		BIT_4
+
+// Card states, ISO 14443-3 ch. 6.3
+#define STATE_IDLE		0
+#define STATE_READY		1
+#define STATE_ACTIVE	2
+#define STATE_HALT		3
+
+#define MAX_BITS	(64 * 8)
+#define MAX_EVENTS	4
+
+#define MEMORY_SIZE		25 // internal buffer of Mem command
+#define SELFTEST		0x09 // SelfTest bits of AutoTestReg
+
+// RF link, in permille of the reset configuration at nominal coupling:
+// field at the card, from drivers conductance and coupling, must power the card,
+// its answer at the receiver, amplified by RxGain, must reach MinLevel,
+// and is clipped when too strong.
+#define POWER_MIN		300
+#define SIGNAL_MIN		500
+#define SIGNAL_MAX		12000
+
+
+typedef struct Frame {
+	uint8_t bits[MAX_BITS]; // one bit per byte, LSB first as on air
+	uint16_t size;
+} Frame_t;
+
+
+typedef struct Event {
+	uint64_t at;
+	uint8_t comIrq;
+	uint8_t divIrq;
+	bool rx; // move received frame into FIFO
+	bool idle; // command terminates
+} Event_t;
+
+
+static uint8_t regs[64];
+static uint8_t fifo[64];
+static uint8_t fifoLevel;
+static uint8_t memory[MEMORY_SIZE]; // kept by soft reset, undefined at power-on
+
+static SimCard_t *field[SIM_MAX_CARDS];
+static SimStats_t stats;
+
+static Event_t events[MAX_EVENTS];
+static uint8_t eventCount;
+
+static Frame_t rxFrame; // response waiting for its rx event
+static uint16_t rxCollision; // first collided bit + 1, 0 if none
+static uint64_t readyAt; // oscillator is stable from this time
+
+// Frames corrupted on air, per 1000, and state of their generator
+static uint16_t noise;
+static uint32_t noiseState;
+static uint16_t coupling = 100;
+
+// SPI frame decoder
+static bool firstByte;
+static bool reading;
+static uint8_t address;
+
+// State of a reader while another one is simulated, see sim_load()
+typedef struct SimReader {
+	uint8_t regs[64];
+	uint8_t fifo[64];
+	uint8_t fifoLevel;
+	uint8_t memory[MEMORY_SIZE];
+	SimCard_t *field[SIM_MAX_CARDS];
+	SimStats_t stats;
+	Event_t events[MAX_EVENTS];
+	uint8_t eventCount;
+	Frame_t rxFrame;
+	uint16_t rxCollision;
+	uint64_t readyAt;
+	uint16_t noise;
+	uint32_t noiseState;
+	uint16_t coupling;
+	bool firstByte;
+	bool reading;
+	uint8_t address;
+} SimReader_t;
+
+static SimReader_t readers[SIM_MAX_READERS] = {
+	{.coupling = 100}, {.coupling = 100}, {.coupling = 100}, {.coupling = 100}
+};
+
+static uint8_t loaded; // reader whose state is in the variables above
+static uint8_t current; // reader of mfrc522_sim_ functions
+
+static void sim_select(void *context, bool selected);
+static uint8_t sim_transfer(void *context, uint8_t data);
+static void sim_reset(void *context);
+
+// Context is the saved state of the reader
+#define SIM_DEVICE(reader)	{sim_select, sim_transfer, sim_reset, &readers[reader]}
+
+static const SPIDevice_t devices[SIM_MAX_READERS] = {
+	SIM_DEVICE(0), SIM_DEVICE(1), SIM_DEVICE(2), SIM_DEVICE(3)
+};
+
+static void sim_load(uint8_t reader);
+static void sim_loadContext(void *context);
+
+static void sim_powerOn(void);
+static void sim_update(void);
+static void sim_schedule(uint64_t at, uint8_t comIrq, uint8_t divIrq, bool rx, bool idle);
+static uint8_t sim_readRegister(uint8_t reg);
+static void sim_writeRegister(uint8_t reg, uint8_t data);
+static void sim_execute(uint8_t command);
+static void sim_transmit(bool receive);
+static void sim_authenticate(void);
+static void sim_fieldOff(void);
+static bool sim_fieldOn(void);
+static uint64_t sim_timerPeriod(void);
+static uint32_t sim_fieldStrength(void);
+static uint32_t sim_signal(uint32_t strength);
+static uint32_t sim_gain(void);
+static uint32_t sim_minLevel(void);
+static bool sim_noisy(uint32_t permille);
+static uint16_t sim_crc(const uint8_t *data, uint16_t size);
+static void sim_memory(void);
+static void sim_selfTest(void);
+static uint16_t crc_a(uint16_t crc, const uint8_t *data, uint16_t size);
+
+static void frame_fromBytes(Frame_t *frame, const uint8_t *data, uint16_t size, uint8_t lastBits);
+static void frame_appendByte(Frame_t *frame, uint8_t data);
+static uint8_t frame_byte(const Frame_t *frame, uint16_t index);
+static uint64_t frame_airTime(const Frame_t *frame);
+
+static bool card_receive(SimCard_t *card, const Frame_t *rx, Frame_t *tx);
+static void card_cascade(const SimCard_t *card, uint8_t level, uint8_t *buffer);
+static uint8_t card_levels(const SimCard_t *card);
+static void card_error(SimCard_t *card);
+static void card_powerOff(SimCard_t *card);
+static void card_nak(Frame_t *tx, uint8_t nak);
+static void card_appendCRC(Frame_t *tx);
+
+
+void mfrc522_sim_init(void) {
+	sim_load(current);
+	mfrc522_sim_clearField();
+	mfrc522_sim_resetStats();
+	memset(memory, 0x5A, sizeof(memory));
+	sim_powerOn();
+}
+
+
+const SPIDevice_t* mfrc522_sim_device(void) {
+	return &devices[current];
+}
+
+
+void mfrc522_sim_useReader(uint8_t reader) {
+	if (reader < SIM_MAX_READERS) {
+		current = reader;
+	}
+}
+
+
+void mfrc522_sim_createCard(SimCard_t *card, SimCardType_t type, const uint8_t *uid, uint8_t size) {
+	memset(card, 0, sizeof(*card));
+	memcpy(card->uid, uid, size);
+	card->size = size;
+	card->type = type;
+	card->authSector = -1;
+	card->writeBlock = -1;
+
+	if (type == SIM_CARD_CLASSIC_1K) {
+		// Manufacturer block
+		memcpy(card->memory, uid, size);
+
+		if (size == 4) {
+			card->memory[4] = uid[0] ^ uid[1] ^ uid[2] ^ uid[3];
+			card->memory[5] = 0x08;
+			card->memory[6] = 0x04;
+		}
+
+		// Sector trailers: key A, access bits, key B
+		static const uint8_t trailer[16] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+											0xFF, 0x07, 0x80, 0x69,
+											0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+		for (uint8_t sector = 0; sector < 16; sector++) {
+			memcpy(card->memory + (sector*4 + 3) * 16, trailer, 16);
+		}
+	}
+	else {
+		// Serial number and BCCs, pages 0-2
+		card->memory[0] = uid[0];
+		card->memory[1] = uid[1];
+		card->memory[2] = uid[2];
+		card->memory[3] = 0x88 ^ uid[0] ^ uid[1] ^ uid[2];
+		card->memory[4] = uid[3];
+		card->memory[5] = uid[4];
+		card->memory[6] = uid[5];
+		card->memory[7] = uid[6];
+		card->memory[8] = uid[3] ^ uid[4] ^ uid[5] ^ uid[6];
+	}
+}
+
+
+bool mfrc522_sim_addCard(SimCard_t *card) {
+	sim_load(current);
+
+	for (uint8_t i = 0; i < SIM_MAX_CARDS; i++) {
+		if (field[i] == NULL) {
+			card->state = STATE_IDLE;
+			card->halted = false;
+			card->authSector = -1;
+			card->writeBlock = -1;
+			field[i] = card;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void mfrc522_sim_removeCard(SimCard_t *card) {
+	sim_load(current);
+
+	for (uint8_t i = 0; i < SIM_MAX_CARDS; i++) {
+		if (field[i] == card) {
+			field[i] = NULL;
+		}
+	}
+}
+
+
+void mfrc522_sim_clearField(void) {
+	sim_load(current);
+
+	memset(field, 0, sizeof(field));
+}
+
+
+void mfrc522_sim_setNoise(uint16_t permille) {
+	sim_load(current);
+
+	noise = permille;
+	noiseState = 1;
+}
+
+
+void mfrc522_sim_setCoupling(uint16_t percent) {
+	sim_load(current);
+
+	coupling = percent;
+}
+
+
+uint8_t mfrc522_sim_peek(uint8_t reg) {
+	sim_load(current);
+
+	sim_update();
+
+	if (reg == FIFOLevelReg) {
+		return fifoLevel;
+	}
+
+	return regs[reg & 0x3F];
+}
+
+
+void mfrc522_sim_getStats(SimStats_t *__stats) {
+	sim_load(current);
+
+	*__stats = stats;
+}
+
+
+void mfrc522_sim_resetStats(void) {
+	sim_load(current);
+
+	memset(&stats, 0, sizeof(stats));
+}
+
+/**************************** SPI device *************************************/
+
+void sim_select(void *context, bool selected) {
+	sim_loadContext(context);
+
+	if (selected) {
+		firstByte = true;
+	}
+}
+
+
+uint8_t sim_transfer(void *context, uint8_t data) {
+	sim_loadContext(context);
+
+	// Address byte: MSB = 1 is Read, bit 6-1 is Address.
+	// See chapter 8.1.2 of MFRC522 datasheet.
+	if (firstByte) {
+		firstByte = false;
+		reading = data & 0x80;
+		address = (data >> 1) & 0x3F;
+		return 0;
+	}
+
+	if (reading) {
+		// Every byte sent during a read is the next address.
+		uint8_t value = sim_readRegister(address);
+		address = (data >> 1) & 0x3F;
+		return value;
+	}
+
+	sim_writeRegister(address, data);
+	return 0;
+}
+
+
+void sim_reset(void *context) {
+	sim_loadContext(context);
+
+	sim_powerOn();
+	readyAt = host_time_ns() + HARDRESET_NS;
+}
+
+
+void sim_loadContext(void *context) {
+	sim_load((SimReader_t*)context - readers);
+}
+
+
+void sim_load(uint8_t reader) {
+	if (reader == loaded) {
+		return;
+	}
+
+	SimReader_t *from = &readers[loaded];
+	const SimReader_t *to = &readers[reader];
+
+	memcpy(from->regs, regs, sizeof(regs));
+	memcpy(from->fifo, fifo, sizeof(fifo));
+	from->fifoLevel = fifoLevel;
+	memcpy(from->memory, memory, sizeof(memory));
+	memcpy(from->field, field, sizeof(field));
+	from->stats = stats;
+	memcpy(from->events, events, sizeof(events));
+	from->eventCount = eventCount;
+	from->rxFrame = rxFrame;
+	from->rxCollision = rxCollision;
+	from->readyAt = readyAt;
+	from->noise = noise;
+	from->noiseState = noiseState;
+	from->coupling = coupling;
+	from->firstByte = firstByte;
+	from->reading = reading;
+	from->address = address;
+
+	memcpy(regs, to->regs, sizeof(regs));
+	memcpy(fifo, to->fifo, sizeof(fifo));
+	fifoLevel = to->fifoLevel;
+	memcpy(memory, to->memory, sizeof(memory));
+	memcpy(field, to->field, sizeof(field));
+	stats = to->stats;
+	memcpy(events, to->events, sizeof(events));
+	eventCount = to->eventCount;
+	rxFrame = to->rxFrame;
+	rxCollision = to->rxCollision;
+	readyAt = to->readyAt;
+	noise = to->noise;
+	noiseState = to->noiseState;
+	coupling = to->coupling;
+	firstByte = to->firstByte;
+	reading = to->reading;
+	address = to->address;
+
+	loaded = reader;
+}
+
+/**************************** Register file **********************************/
+
+void sim_powerOn(void) {
+	static const uint8_t defaults[64] = {
+		[CommandReg] = 0x20, [ComIEnReg] = 0x80, [ComIrqReg] = 0x14,
+		[Status1Reg] = 0x21, [WaterLevelReg] = 0x08, [ControlReg] = 0x10,
+		[CollReg] = 0xA0, [ModeReg] = 0x3F, [TxControlReg] = 0x80,
+		[TxSelReg] = 0x10, [RxSelReg] = 0x84, [RxThresholdReg] = 0x84,
+		[DemodReg] = 0x4D, [Reserved12] = 0x62, [SerialSpeedReg] = 0xEB,
+		[CRCResultRegMSB] = 0xFF, [CRCResultRegLSB] = 0xFF, [ModWidthReg] = 0x26,
+		[RFCfgReg] = 0x48, [GsNReg] = 0x88, [CWGsPReg] = 0x20, [ModGsPReg] = 0x20,
+		[TestPinEnReg] = 0x80, [AutoTestReg] = 0x40, [VersionReg] = 0x92
+	};
+
+	memcpy(regs, defaults, sizeof(regs));
+	fifoLevel = 0;
+	eventCount = 0;
+	readyAt = host_time_ns() + SOFTRESET_NS;
+	sim_fieldOff();
+}
+
+
+uint8_t sim_readRegister(uint8_t reg) {
+	sim_update();
+	stats.regReads++;
+
+	switch (reg) {
+		case CommandReg:
+			// PowerDown stays set until the oscillator is stable.
+			return regs[CommandReg] | (host_time_ns() < readyAt ? BIT_4 : 0);
+
+		case FIFODataReg: {
+			if (fifoLevel == 0) {
+				return 0;
+			}
+
+			uint8_t data = fifo[0];
+			memmove(fifo, fifo + 1, --fifoLevel);
+			return data;
+		}
+
+		case FIFOLevelReg:
+			return fifoLevel;
+
+		default:
+			return regs[reg];
+	}
+}
+
+
+void sim_writeRegister(uint8_t reg, uint8_t data) {
+	sim_update();
+	stats.regWrites++;
+
+	if (host_time_ns() < readyAt) {
+		return; // not ready, write is lost
+	}
+
+	switch (reg) {
+		case CommandReg:
+			if (data & BIT_4) {
+				// Soft power-down: analog part and field are off.
+				eventCount = 0;
+				sim_fieldOff();
+			}
+			else if (regs[CommandReg] & BIT_4) {
+				// Leaving soft power-down restarts the oscillator.
+				readyAt = host_time_ns() + SOFTRESET_NS;
+			}
+
+			regs[CommandReg] = data & 0x3F;
+
+			sim_execute(data & 0x0F);
+			break;
+
+		case ComIrqReg:
+			// Set1: write 1 to set marked bits, 0 to clear them.
+			if (data & BIT_7) {
+				regs[ComIrqReg] |= data & 0x7F;
+			}
+			else {
+				regs[ComIrqReg] &= ~data;
+			}
+			break;
+
+		case DivIrqReg:
+			if (data & BIT_7) {
+				regs[DivIrqReg] |= data & 0x14;
+			}
+			else {
+				regs[DivIrqReg] &= ~data;
+			}
+			break;
+
+		case FIFODataReg:
+			if (fifoLevel < sizeof(fifo)) {
+				fifo[fifoLevel++] = data;
+			}
+			else {
+				regs[ErrorReg] |= ERR_BUFFER;
+			}
+			break;
+
+		case FIFOLevelReg:
+			if (data & BIT_7) {
+				fifoLevel = 0;
+				regs[ErrorReg] &= ~ERR_BUFFER;
+			}
+			break;
+
+		case BitFramingReg:
+			regs[BitFramingReg] = data & 0x77;
+
+			if ((data & BIT_7) && (regs[CommandReg] & 0x0F) == MFRC522_CMD_TRANSCEIVE) {
+				sim_transmit(true);
+			}
+			break;
+
+		case CollReg:
+			regs[CollReg] = (regs[CollReg] & 0x7F) | (data & BIT_7);
+			break;
+
+		case TxControlReg:
+			regs[TxControlReg] = data;
+
+			if ((data & 0x03) == 0) {
+				sim_fieldOff();
+			}
+			break;
+
+		case ErrorReg:
+		case Status1Reg:
+		case CRCResultRegMSB:
+		case CRCResultRegLSB:
+		case VersionReg:
+			break; // read-only
+
+		default:
+			regs[reg] = data;
+			break;
+	}
+}
+
+
+void sim_execute(uint8_t command) {
+	switch (command) {
+		case MFRC522_CMD_IDLE:
+			eventCount = 0;
+			break;
+
+		case MFRC522_CMD_SOFTRESET:
+			sim_powerOn();
+			break;
+
+		case MFRC522_CMD_MEM:
+			sim_memory();
+			break;
+
+		case MFRC522_CMD_CALCCRC: {
+			if ((regs[AutoTestReg] & 0x0F) == SELFTEST) {
+				sim_selfTest();
+				break;
+			}
+
+			uint16_t crc = sim_crc(fifo, fifoLevel);
+
+			regs[CRCResultRegLSB] = crc & 0xFF;
+			regs[CRCResultRegMSB] = crc >> 8;
+			sim_schedule(host_time_ns() + fifoLevel * CRC_NS, 0, IRQ_CRC, false, false);
+			fifoLevel = 0;
+			break;
+		}
+
+		case MFRC522_CMD_TRANSMIT:
+			sim_transmit(false);
+			break;
+
+		case MFRC522_CMD_AUTHENT:
+			sim_authenticate();
+			break;
+
+		default:
+			break; // TRANSCEIVE waits for StartSend
+	}
+}
+
+
+void sim_schedule(uint64_t at, uint8_t comIrq, uint8_t divIrq, bool rx, bool idle) {
+	if (eventCount < MAX_EVENTS) {
+		events[eventCount++] = (Event_t){at, comIrq, divIrq, rx, idle};
+	}
+}
+
+
+void sim_update(void) {
+	uint64_t now = host_time_ns();
+
+	for (uint8_t i = 0; i < eventCount; ) {
+		Event_t event = events[i];
+
+		if (event.at > now) {
+			i++;
+			continue;
+		}
+
+		memmove(events + i, events + i + 1, (--eventCount - i) * sizeof(Event_t));
+
+		if (event.comIrq & IRQ_TIMER) {
+			stats.timeouts++;
+		}
+
+		if (event.rx) {
+			// RxAlign: first received bit is stored at this bit position.
+			uint8_t align = (regs[BitFramingReg] >> 4) & 0x07;
+			uint16_t total = align + rxFrame.size;
+			uint8_t size = (total + 7) / 8;
+
+			if (size > sizeof(fifo) - fifoLevel) {
+				size = sizeof(fifo) - fifoLevel;
+				regs[ErrorReg] |= ERR_BUFFER;
+			}
+
+			memset(fifo + fifoLevel, 0, size);
+
+			for (uint16_t bit = 0; bit < rxFrame.size && (align + bit) / 8 < size; bit++) {
+				fifo[fifoLevel + (align + bit) / 8] |= rxFrame.bits[bit] << ((align + bit) % 8);
+			}
+
+			fifoLevel += size;
+			regs[ControlReg] = (regs[ControlReg] & ~0x07) | (total % 8);
+
+			if (rxCollision) {
+				uint16_t pos = align + rxCollision;
+
+				regs[ErrorReg] |= ERR_COLL;
+
+				if (pos <= 32) {
+					regs[CollReg] = (regs[CollReg] & BIT_7) | (pos & 0x1F);
+				}
+				else {
+					regs[CollReg] = (regs[CollReg] & BIT_7) | BIT_5;
+				}
+			}
+		}
+
+		regs[ComIrqReg] |= event.comIrq;
+		regs[DivIrqReg] |= event.divIrq;
+
+		if (regs[ErrorReg]) {
+			regs[ComIrqReg] |= IRQ_ERR;
+		}
+
+		if (event.idle) {
+			regs[CommandReg] &= ~0x0F;
+		}
+	}
+}
+
+
+void sim_memory(void) {
+	// Empty FIFO: the internal buffer is read out, else 25 bytes are stored
+	if (fifoLevel == 0) {
+		memcpy(fifo, memory, MEMORY_SIZE);
+		fifoLevel = MEMORY_SIZE;
+	}
+	else {
+		uint8_t size = fifoLevel < MEMORY_SIZE ? fifoLevel : MEMORY_SIZE;
+
+		memcpy(memory, fifo, size);
+		memmove(fifo, fifo + size, fifoLevel - size);
+		fifoLevel -= size;
+	}
+
+	regs[CommandReg] &= ~0x0F;
+	regs[ComIrqReg] |= IRQ_IDLE;
+}
+
+
+void sim_selfTest(void) {
+	// Output of MFRC522 v2.0, datasheet ch. 16.1.1. It depends on the internal
+	// buffer, which must be cleared first.
+	static const uint8_t reference[64] = {
+		0x00, 0xEB, 0x66, 0xBA, 0x57, 0xBF, 0x23, 0x95,
+		0xD0, 0xE3, 0x0D, 0x3D, 0x27, 0x89, 0x5C, 0xDE,
+		0x9D, 0x3B, 0xA7, 0x00, 0x21, 0x5B, 0x89, 0x82,
+		0x51, 0x3A, 0xEB, 0x02, 0x0C, 0xA5, 0x00, 0x49,
+		0x7C, 0x84, 0x4D, 0xB3, 0xCC, 0xD2, 0x1B, 0x81,
+		0x5D, 0x48, 0x76, 0xD5, 0x71, 0x61, 0x21, 0xA9,
+		0x86, 0x96, 0x83, 0x38, 0xCF, 0x9D, 0x5B, 0x6D,
+		0xDC, 0x15, 0xBA, 0x3E, 0x7D, 0x95, 0x3B, 0x2F
+	};
+
+	for (uint8_t i = 0; i < sizeof(reference); i++) {
+		fifo[i] = reference[i] ^ memory[i % MEMORY_SIZE];
+	}
+
+	fifoLevel = sizeof(reference);
+	sim_schedule(host_time_ns() + sizeof(reference) * CRC_NS, 0, IRQ_CRC, false, false);
+}
+
+/**************************** Air interface **********************************/
+
+void sim_transmit(bool receive) {
+	Frame_t tx;
+	uint8_t lastBits = regs[BitFramingReg] & 0x07;
+
+	frame_fromBytes(&tx, fifo, fifoLevel, lastBits);
+	fifoLevel = 0;
+
+	regs[ErrorReg] = 0;
+	regs[CollReg] = (regs[CollReg] & BIT_7) | BIT_5;
+	regs[BitFramingReg] &= ~BIT_7;
+
+	if (regs[TxModeReg] & BIT_7) {
+		card_appendCRC(&tx);
+	}
+
+	uint64_t now = host_time_ns();
+	uint64_t txEnd = now + frame_airTime(&tx);
+
+	stats.frames++;
+	stats.air_ns += txEnd - now;
+
+	// Timer starts at the end of transmission if TAuto is set.
+	uint64_t timeout = (regs[TModeReg] & BIT_7) ? txEnd + sim_timerPeriod() : UINT64_MAX;
+
+	// Every card answers, overlapping bits collide.
+	Frame_t answer;
+	bool answered = false;
+
+	rxFrame.size = 0;
+	rxCollision = 0;
+
+	uint32_t strength = sim_fieldOn() ? sim_fieldStrength() : 0;
+
+	if (strength < POWER_MIN) {
+		// Cards are not powered, or lose power
+		for (uint8_t i = 0; i < SIM_MAX_CARDS; i++) {
+			if (field[i]) {
+				card_powerOff(field[i]);
+			}
+		}
+	}
+	else if (sim_noisy((uint32_t)noise * 1000 / strength)) {
+		// Cards see a broken frame, more likely in a weak field
+		for (uint8_t i = 0; i < SIM_MAX_CARDS; i++) {
+			if (field[i]) {
+				card_error(field[i]);
+			}
+		}
+	}
+	else {
+		for (uint8_t i = 0; i < SIM_MAX_CARDS; i++) {
+			if (field[i] == NULL || !card_receive(field[i], &tx, &answer)) {
+				continue;
+			}
+
+			if (!answered) {
+				rxFrame = answer;
+				answered = true;
+				continue;
+			}
+
+			for (uint16_t bit = 0; bit < answer.size || bit < rxFrame.size; bit++) {
+				bool same = bit < answer.size && bit < rxFrame.size
+							&& answer.bits[bit] == rxFrame.bits[bit];
+
+				if (!same && !rxCollision) {
+					rxCollision = bit + 1;
+				}
+			}
+
+			if (answer.size > rxFrame.size) {
+				rxFrame.size = answer.size;
+			}
+		}
+	}
+
+	uint32_t signal = sim_signal(strength);
+
+	if (answered && signal * 1000 < SIGNAL_MIN * sim_minLevel()) {
+		// Answer below MinLevel is not seen
+		answered = false;
+		rxFrame.size = 0;
+		rxCollision = 0;
+	}
+
+	// Interference is amplified by RxGain and let through by a low MinLevel
+	if (answered && rxFrame.size > 0
+		&& (signal > SIGNAL_MAX || sim_noisy((uint32_t)noise * sim_gain() / sim_minLevel()))) {
+
+		rxFrame.bits[rxFrame.size / 2] ^= 1;
+		regs[ErrorReg] |= ERR_PARITY;
+	}
+
+	if (rxCollision) {
+		stats.collisions++;
+
+		// ValuesAfterColl = 0: bits after a collision are cleared.
+		if (!(regs[CollReg] & BIT_7)) {
+			for (uint16_t bit = rxCollision - 1; bit < rxFrame.size; bit++) {
+				rxFrame.bits[bit] = 0;
+			}
+		}
+	}
+
+	if (!receive) {
+		sim_schedule(txEnd, IRQ_TX | IRQ_IDLE, 0, false, true);
+		sim_schedule(timeout, IRQ_TIMER, 0, false, false);
+		return;
+	}
+
+	sim_schedule(txEnd, IRQ_TX, 0, false, false);
+
+	if (!answered) {
+		sim_schedule(timeout, IRQ_TIMER, 0, false, false);
+		return;
+	}
+
+	if (regs[RxModeReg] & BIT_7) {
+		// RxCRCEn: CRC is checked and not stored in FIFO.
+		uint8_t bytes[64];
+		uint8_t size = rxFrame.size / 8;
+
+		for (uint8_t i = 0; i < size; i++) {
+			bytes[i] = frame_byte(&rxFrame, i);
+		}
+
+		if (size < 2 || rxFrame.size % 8 || sim_crc(bytes, size) != 0) {
+			regs[ErrorReg] |= ERR_CRC;
+		}
+		else {
+			rxFrame.size -= 16;
+		}
+	}
+
+	uint64_t rxEnd = txEnd + FDT_NS + frame_airTime(&rxFrame);
+
+	stats.responses++;
+	stats.air_ns += rxEnd - txEnd;
+
+	sim_schedule(rxEnd, IRQ_RX, 0, true, false);
+}
+
+
+void sim_authenticate(void) {
+	// FIFO: command, block, 6-byte key, 4-byte UID.
+	// Crypto1 itself is not simulated, only the key is checked.
+	uint8_t buffer[12];
+	memcpy(buffer, fifo, sizeof(buffer));
+	fifoLevel = 0;
+
+	uint64_t now = host_time_ns();
+	uint64_t end = now + 4 * (FDT_NS + 5 * 9 * ETU_NS); // 2 pass of 4-5 bytes each way
+
+	stats.frames += 2;
+	stats.air_ns += end - now;
+
+	for (uint8_t i = 0; i < SIM_MAX_CARDS; i++) {
+		SimCard_t *card = field[i];
+
+		if (card == NULL || card->state != STATE_ACTIVE || card->type != SIM_CARD_CLASSIC_1K) {
+			continue;
+		}
+
+		uint8_t block = buffer[1];
+		const uint8_t *trailer = card->memory + ((block / 4) * 4 + 3) * 16;
+		const uint8_t *key = (buffer[0] == MIFARE_CMD_AUTHENT1A) ? trailer : trailer + 10;
+
+		if (block < 64 && memcmp(key, buffer + 2, 6) == 0
+			&& memcmp(card->uid + card->size - 4, buffer + 8, 4) == 0) {
+
+			card->authSector = block / 4;
+			regs[Status2Reg] |= BIT_3; // MFCrypto1On
+			sim_schedule(end, IRQ_IDLE, 0, false, true);
+			stats.responses += 2;
+			return;
+		}
+
+		card_error(card);
+	}
+
+	if (regs[TModeReg] & BIT_7) {
+		sim_schedule(end + sim_timerPeriod(), IRQ_TIMER, 0, false, false);
+	}
+}
+
+
+void sim_fieldOff(void) {
+	for (uint8_t i = 0; i < SIM_MAX_CARDS; i++) {
+		if (field[i]) {
+			card_powerOff(field[i]);
+		}
+	}
+
+	regs[Status2Reg] &= ~BIT_3;
+}
+
+
+bool sim_fieldOn(void) {
+	return (regs[TxControlReg] & 0x03) && !(regs[CommandReg] & BIT_4);
+}
+
+
+uint64_t sim_timerPeriod(void) {
+	uint16_t prescaler = ((regs[TModeReg] & 0x0F) << 8) | regs[TPrescalerReg];
+	uint16_t reload = (regs[TReloadRegH] << 8) | regs[TReloadRegL];
+
+	return (uint64_t)(reload + 1) * (2 * prescaler + 1) * 1000000000ULL / FC_HZ;
+}
+
+
+uint32_t sim_fieldStrength(void) {
+	// Conductance of p-drivers (CWGsPReg) and n-drivers (GsNReg bits 7-4), 1000 at reset
+	uint32_t drive = ((regs[CWGsPReg] & 0x3F) * 1000 / 32 + (regs[GsNReg] >> 4) * 1000 / 8) / 2;
+
+	return drive * coupling / 100;
+}
+
+
+uint32_t sim_signal(uint32_t strength) {
+	// Load modulation is coupled back to the antenna
+	return strength * coupling / 100 * sim_gain() / 1000;
+}
+
+
+uint32_t sim_gain(void) {
+	// RxGain of RFCfgReg: 18, 23, 18, 23, 33, 38, 43, 48 dB, 1000 at 33 dB
+	static const uint16_t gains[8] = {178, 316, 178, 316, 1000, 1778, 3162, 5623};
+
+	return gains[(regs[RFCfgReg] >> 4) & 0x07];
+}
+
+
+uint32_t sim_minLevel(void) {
+	// MinLevel of RxThresholdReg, 1000 at reset
+	uint32_t level = regs[RxThresholdReg] >> 4;
+
+	return level ? level * 1000 / 8 : 1000 / 16;
+}
+
+
+bool sim_noisy(uint32_t permille) {
+	if (permille == 0) {
+		return false;
+	}
+
+	// Same LCG as most C libraries, high bits are the random ones
+	noiseState = noiseState * 1103515245UL + 12345;
+
+	if ((noiseState >> 16) % 1000 >= permille) {
+		return false;
+	}
+
+	stats.corrupted++;
+	return true;
+}
+
+
+uint16_t sim_crc(const uint8_t *data, uint16_t size) {
+	// CRCPreset of ModeReg
+	static const uint16_t presets[4] = {0x0000, 0x6363, 0xA671, 0xFFFF};
+
+	return crc_a(presets[regs[ModeReg] & 0x03], data, size);
+}
+
+
+uint16_t crc_a(uint16_t crc, const uint8_t *data, uint16_t size) {
+	for (uint16_t i = 0; i < size; i++) {
+		uint8_t ch = data[i] ^ (crc & 0xFF);
+		ch ^= ch << 4;
+		crc = (crc >> 8) ^ ((uint16_t)ch << 8) ^ ((uint16_t)ch << 3) ^ (ch >> 4);
+	}
+
+	return crc;
+}
+
+/**************************** Frames *****************************************/
+
+void frame_fromBytes(Frame_t *frame, const uint8_t *data, uint16_t size, uint8_t lastBits) {
+	frame->size = 0;
+
+	for (uint16_t i = 0; i < size; i++) {
+		uint8_t bits = (i == size - 1 && lastBits) ? lastBits : 8;
+
+		for (uint8_t bit = 0; bit < bits; bit++) {
+			frame->bits[frame->size++] = (data[i] >> bit) & 0x01;
+		}
+	}
+}
+
+
+void frame_appendByte(Frame_t *frame, uint8_t data) {
+	for (uint8_t bit = 0; bit < 8; bit++) {
+		frame->bits[frame->size++] = (data >> bit) & 0x01;
+	}
+}
+
+
+uint8_t frame_byte(const Frame_t *frame, uint16_t index) {
+	uint8_t data = 0;
+
+	for (uint8_t bit = 0; bit < 8 && index*8 + bit < frame->size; bit++) {
+		data |= frame->bits[index*8 + bit] << bit;
+	}
+
+	return data;
+}
+
+
+uint64_t frame_airTime(const Frame_t *frame) {
+	// SOF + data bits + one parity bit per complete byte, unless ParityDisable + EOF
+	uint16_t parity = (regs[MfRxReg] & BIT_4) ? 0 : frame->size / 8;
+
+	return (uint64_t)(1 + frame->size + parity + 1) * ETU_NS;
+}
+
+/**************************** Virtual cards **********************************/
+
+bool card_receive(SimCard_t *card, const Frame_t *rx, Frame_t *tx) {
+	uint8_t cmd = frame_byte(rx, 0);
+
+	tx->size = 0;
+
+	// Short frame: REQA or WUPA
+	if (rx->size == 7) {
+		bool wakeup = (cmd == MIFARE_CMD_WUPA && card->state == STATE_HALT);
+
+		if ((cmd == MIFARE_CMD_REQA || cmd == MIFARE_CMD_WUPA)
+			&& (card->state == STATE_IDLE || wakeup)) {
+
+			// ATQA: bit 7-6 is UID size, bit 2 is bit frame anticollision.
+			card->state = STATE_READY;
+			card->level = 0;
+			frame_appendByte(tx, ((card_levels(card) - 1) << 6) | 0x04);
+			frame_appendByte(tx, 0x00);
+			return true;
+		}
+
+		card_error(card);
+		return false;
+	}
+
+	if (card->state == STATE_IDLE || card->state == STATE_HALT) {
+		return false;
+	}
+
+	if (card->state == STATE_READY) {
+		uint8_t level = (cmd - MIFARE_CMD_SELECTCL1) / 2;
+		uint8_t nvb = frame_byte(rx, 1);
+		uint8_t cascade[5];
+
+		if (rx->size < 16 || (cmd != MIFARE_CMD_SELECTCL1 && cmd != MIFARE_CMD_SELECTCL2
+			&& cmd != MIFARE_CMD_SELECTCL3) || level != card->level) {
+
+			card_error(card);
+			return false;
+		}
+
+		card_cascade(card, level, cascade);
+
+		// SELECT: 7 bytes + CRC_A
+		if (nvb == 0x70) {
+			uint8_t bytes[9];
+
+			for (uint8_t i = 0; i < 9; i++) {
+				bytes[i] = frame_byte(rx, i);
+			}
+
+			if (rx->size != 72 || crc_a(0x6363, bytes, 9) != 0) {
+				card_error(card);
+				return false;
+			}
+
+			if (memcmp(bytes + 2, cascade, 5) != 0) {
+				return false; // another card is selected
+			}
+
+			if (level + 1 < card_levels(card)) {
+				card->level++;
+				frame_appendByte(tx, 0x04); // UID not complete
+			}
+			else {
+				card->state = STATE_ACTIVE;
+				frame_appendByte(tx, card->type == SIM_CARD_CLASSIC_1K ? 0x08 : 0x00);
+			}
+
+			card_appendCRC(tx);
+			return true;
+		}
+
+		// ANTICOLLISION: NVB tells how many bits are transmitted.
+		uint16_t known = (nvb >> 4) * 8 + (nvb & 0x0F);
+
+		if ((nvb & 0x0F) > 7 || known < 16 || known >= 56 || rx->size != known) {
+			card_error(card);
+			return false;
+		}
+
+		Frame_t uid;
+		frame_fromBytes(&uid, cascade, 5, 0);
+
+		for (uint16_t bit = 16; bit < known; bit++) {
+			if (rx->bits[bit] != uid.bits[bit-16]) {
+				return false; // stays READY
+			}
+		}
+
+		for (uint16_t bit = known - 16; bit < uid.size; bit++) {
+			tx->bits[tx->size++] = uid.bits[bit];
+		}
+
+		return true;
+	}
+
+	// ACTIVE: only standard frames with valid CRC_A
+	uint8_t bytes[64];
+	uint8_t size = rx->size / 8;
+
+	for (uint8_t i = 0; i < size; i++) {
+		bytes[i] = frame_byte(rx, i);
+	}
+
+	if (rx->size % 8 || size < 3 || crc_a(0x6363, bytes, size) != 0) {
+		card_error(card);
+		return false;
+	}
+
+	uint8_t block = bytes[1];
+	uint8_t *memory = card->memory;
+
+	// Second part of WRITE: data
+	if (card->writeBlock >= 0) {
+		if (size != 18) {
+			card->writeBlock = -1;
+			card_nak(tx, 0x00);
+			return true;
+		}
+
+		if (card->type == SIM_CARD_CLASSIC_1K) {
+			memcpy(memory + card->writeBlock * 16, bytes, 16);
+		}
+		else {
+			memcpy(memory + card->writeBlock * 4, bytes, 4);
+		}
+
+		card->writeBlock = -1;
+		card_nak(tx, 0x0A);
+		return true;
+	}
+
+	switch (cmd) {
+		case MIFARE_CMD_HALT:
+			card->state = STATE_HALT;
+			card->halted = true;
+			card->authSector = -1;
+			return false;
+
+		case MIFARE_CMD_READ:
+			if (card->type == SIM_CARD_CLASSIC_1K) {
+				if (block >= 64 || card->authSector != block / 4) {
+					card_nak(tx, 0x04);
+					card_error(card);
+					return true;
+				}
+
+				for (uint8_t i = 0; i < 16; i++) {
+					frame_appendByte(tx, memory[block * 16 + i]);
+				}
+			}
+			else {
+				if (block >= 16) {
+					card_nak(tx, 0x00);
+					card_error(card);
+					return true;
+				}
+
+				// 4 pages, roll over to page 0
+				for (uint8_t i = 0; i < 16; i++) {
+					frame_appendByte(tx, memory[((block + i/4) % 16) * 4 + i%4]);
+				}
+			}
+
+			card_appendCRC(tx);
+			return true;
+
+		case MIFARE_CMD_WRITE:
+			if (card->type == SIM_CARD_CLASSIC_1K) {
+				if (block == 0 || block >= 64 || card->authSector != block / 4) {
+					card_nak(tx, 0x04);
+					card_error(card);
+					return true;
+				}
+			}
+			else if (block < 2 || block >= 16) {
+				card_nak(tx, 0x00);
+				card_error(card);
+				return true;
+			}
+
+			card->writeBlock = block;
+			card_nak(tx, 0x0A);
+			return true;
+
+		default:
+			card_error(card);
+			return false;
+	}
+}
+
+
+void card_cascade(const SimCard_t *card, uint8_t level, uint8_t *buffer) {
+	uint8_t i = 0;
+	const uint8_t *uid = card->uid + 3*level;
+
+	if (level + 1 < card_levels(card)) {
+		buffer[i++] = 0x88; // Cascade Tag
+	}
+
+	while (i < 4) {
+		buffer[i++] = *uid++;
+	}
+
+	buffer[4] = buffer[0] ^ buffer[1] ^ buffer[2] ^ buffer[3];
+}
+
+
+uint8_t card_levels(const SimCard_t *card) {
+	return (card->size == 4) ? 1 : (card->size == 7) ? 2 : 3;
+}
+
+
+void card_error(SimCard_t *card) {
+	// Unexpected frame: back to IDLE, or HALT if the card was halted.
+	card->state = card->halted ? STATE_HALT : STATE_IDLE;
+	card->authSector = -1;
+	card->writeBlock = -1;
+}
+
+
+void card_powerOff(SimCard_t *card) {
+	// Power-up from reset when the field comes back
+	card->state = STATE_IDLE;
+	card->halted = false;
+	card->authSector = -1;
+	card->writeBlock = -1;
+}
+
+
+void card_nak(Frame_t *tx, uint8_t nak) {
+	for (uint8_t bit = 0; bit < 4; bit++) {
+		tx->bits[tx->size++] = (nak >> bit) & 0x01;
+	}
+}
+
+
+void card_appendCRC(Frame_t *tx) {
+	uint8_t bytes[64];
+	uint8_t size = tx->size / 8;
+
+	for (uint8_t i = 0; i < size; i++) {
+		bytes[i] = frame_byte(tx, i);
+	}
+
+	uint16_t crc = crc_a(0x6363, bytes, size);
+
+	frame_appendByte(tx, crc & 0xFF);
+	frame_appendByte(tx, crc >> 8);
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,139 @@
+/** 
+ * @file spi_host.c
+ * @brief SPI bus for Linux host, bytes are passed to an attached device.
+ * @author Nguyen Trong Phuong (aka trongphuongpro)
+ * @date 2026 Oct 18
+ */
+
+
+#include "spi_host.h"
+#include "utils_host.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+static const SPIDevice_t *device;
+static uint32_t clock;
+static uint32_t byte_ns;
+static SPIStats_t stats;
+
+// Wiring limit, see host_spi_setLimit()
+static uint32_t limit;
+static uint32_t glitchState = 1;
+
+static bool host_spi_glitch(void);
+
+
+void host_spi_master_init(const SPIDevice_t *__device, uint32_t speed) {
+	device = __device;
+	host_spi_setClock(speed);
+	host_spi_resetStats();
+}
+
+
+void host_spi_setDevice(const SPIDevice_t *__device) {
+	device = __device;
+}
+
+
+void host_spi_setClock(uint32_t speed) {
+	clock = speed;
+	byte_ns = 8000000000ULL / speed;
+}
+
+
+uint32_t host_spi_getClock(void) {
+	return clock;
+}
+
+
+void host_spi_setLimit(uint32_t speed) {
+	limit = speed;
+	glitchState = 1;
+}
+
+
+void host_spi_select(bool selected) {
+	if (selected) {
+		stats.frames++;
+	}
+
+	device->select(device->context, selected);
+}
+
+
+void host_spi_reset(void) {
+	if (device->reset) {
+		device->reset(device->context);
+	}
+}
+
+
+void host_spi_getStats(SPIStats_t *__stats) {
+	*__stats = stats;
+}
+
+
+void host_spi_resetStats(void) {
+	memset(&stats, 0, sizeof(stats));
+}
+
+
+uint8_t spi_transfer_byte(uint8_t data) {
+	stats.bytes++;
+	stats.time_ns += byte_ns;
+	host_time_advance(byte_ns);
+
+	uint8_t received = device->transfer(device->context, data);
+
+	if (host_spi_glitch()) {
+		received ^= 1 << ((glitchState >> 16) % 8);
+	}
+
+	return received;
+}
+
+
+void spi_send(uint8_t data) {
+	spi_transfer_byte(data);
+}
+
+
+void spi_sendBuffer(const void *buffer, uint16_t len) {
+	const uint8_t *data = (const uint8_t*)buffer;
+
+	for (uint16_t i = 0; i < len; i++) {
+		spi_send(data[i]);
+	}
+}
+
+
+uint8_t spi_receive() {
+	return spi_transfer_byte(0xFF);
+}
+
+
+void spi_receiveBuffer(void *buffer, uint16_t len) {
+	uint8_t *data = (uint8_t*)buffer;
+
+	for (uint16_t i = 0; i < len; i++) {
+		data[i] = spi_receive();
+	}
+}
+
+
+bool host_spi_glitch(void) {
+	if (limit == 0 || clock <= limit) {
+		return false;
+	}
+
+	// Bytes corrupted per 1000 grow with the excess clock, same LCG as the simulator
+	uint32_t permille = (uint64_t)(clock - limit) * 1000 / limit;
+
+	glitchState = glitchState * 1103515245UL + 12345;
+
+	return (glitchState >> 16) % 1000 < permille;
+}
+
+/**************************** End of File ************************************/
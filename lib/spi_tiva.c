@@ -66,6 +66,11 @@ void tiva_spi_slave_init(uint32_t base,
 }
 
 
+void tiva_spi_use(uint32_t base) {
+	SSIBase = base;
+}
+
+
 uint8_t spi_transfer_byte(uint8_t data) {
 	SSIDataPut(SSIBase, data);
 
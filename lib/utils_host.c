@@ -0,0 +1,32 @@
+//! \file utils_host.c
+//! \brief Utility functions for Linux host, used by simulation.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+#include "utils_host.h"
+
+
+static uint64_t now_ns = 0;
+
+
+void delay_ms(uint16_t ms) {
+    host_time_advance(ms * 1000000ULL);
+}
+
+void delay_us(uint16_t us) {
+    host_time_advance(us * 1000ULL);
+}
+
+uint64_t host_time_ns(void) {
+    return now_ns;
+}
+
+uint32_t micros(void) {
+    return now_ns / 1000;
+}
+
+void host_time_advance(uint64_t ns) {
+    now_ns += ns;
+}
+
+/********************* End of File *******************************************/
@@ -12,11 +12,14 @@
 
 
 volatile uint16_t counter = 0;
+static volatile uint32_t millis = 0;
 
 
 static void systick_isr();
 
 void systick_isr() {
+    millis++;
+
     if (counter > 0) {
         counter--;
     }
@@ -34,4 +37,18 @@ void delay_ms(uint16_t ms) {
     while (counter);
 }
 
+uint32_t micros() {
+    uint32_t ms, ticks;
+
+    // SysTick counts down, read again if it reloaded in between
+    do {
+        ms = millis;
+        ticks = SysTickValueGet();
+    } while (ms != millis);
+
+    uint32_t period = SysTickPeriodGet();
+
+    return ms * 1000 + (period - 1 - ticks) / (period / 1000);
+}
+
 /********************* End of File *******************************************/
\ No newline at end of file
@@ -0,0 +1,2469 @@
+
+//! \file mfrc522.c
+//! \brief MFRC522 MIFARE RFID reader
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2020 Mar 6
+
+
+#include "mfrc522.h"
+#include "mfrc522_registers.h"
+#include "mfrc522_status.h"
+
+#include "mfrc522_port.h"
+#include "mfrc522_stats.h"
+#include "mfrc522_trace.h"
+
+#include <stdlib.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(address)	(*(const uint8_t*)(address))
+#endif
+
+#include "spi.h"
+
+
+#define ACTIVATE()		mfrc522_port_select()
+#define DEACTIVATE()	mfrc522_port_deselect()
+#define TRANSFER(data)	mfrc522_port_transfer(data)
+
+// Counters of mfrc522_stats.h, polls are busy-wait iterations of current command.
+// A command nested in another one (CRC check) keeps its polls apart.
+#ifdef MFRC522_STATS
+static uint16_t polls;
+#define STATS_BEGIN()	uint16_t outer = polls; uint32_t start = mfrc522_statsNow(); polls = 0
+#define STATS_POLL()	(polls++)
+#define STATS_END(command, tx, size, status)	\
+	mfrc522_statsRecord(command, tx, size, status, polls, start); polls = outer
+// Overlapping commands of several readers: polls are rounds over the readers
+#define STATS_OVERLAP_START(overlap, i)	\
+	((overlap)->begun[i] = mfrc522_statsNow(), (overlap)->polled[i] = polls)
+#define STATS_OVERLAP_END(overlap, i, command, tx, size, status)	\
+	mfrc522_statsRecord(command, tx, size, status,	\
+						polls - (overlap)->polled[i], (overlap)->begun[i])
+#else
+#define STATS_BEGIN()
+#define STATS_POLL()
+#define STATS_END(command, tx, size, status)
+#define STATS_OVERLAP_START(overlap, i)
+#define STATS_OVERLAP_END(overlap, i, command, tx, size, status)
+#endif
+
+// Power-down counters of mfrc522_stats.h
+#ifdef MFRC522_STATS
+#define STATS_WAKE_BEGIN()	uint32_t wakeStart = mfrc522_statsNow()
+#define STATS_WAKE()		mfrc522_statsWake(wakeStart)
+#define STATS_SLEEP()		mfrc522_statsSleep()
+#else
+#define STATS_WAKE_BEGIN()
+#define STATS_WAKE()
+#define STATS_SLEEP()
+#endif
+
+// Events of mfrc522_trace.h
+#ifdef MFRC522_TRACE
+#define TRACE(tag, value)	mfrc522_traceEvent(tag, value)
+#else
+#define TRACE(tag, value)
+#endif
+
+// Reload values of internal timer, f_timer = 40kHz
+#define DEFAULT_TIMEOUT		0x07D0 // 50ms
+#define PRESENCE_TIMEOUT	0x00C8 // 5ms
+#define TIMER_TICK_US		25
+
+// Readiness polling after reset: oscillator is stable in less than 1ms,
+// bounded to 10ms.
+#define READY_INTERVAL_US	50
+#define READY_POLLS			200
+
+// MCU-side deadlines of interrupt waits. A command ends within its timer timeout,
+// which starts at the end of transmission, plus transmission and reception of
+// a full FIFO at 106 kbit/s. Polls are busy first, as most frames end meanwhile,
+// then paced by POLL_INTERVAL_US so the time waited is known without an MCU timer.
+#define BUSY_POLLS			512
+#define POLL_INTERVAL_US	20
+#define FRAME_MARGIN_US		12000
+#define CRC_DEADLINE_US		1000
+#define CRC_A_PRESET		0x6363 // ISO 14443-3 part 6.2.4, set by every profile
+
+// Collision resolved by mfrc522_anticollisionAnswer(), or another frame to
+// send by mfrc522_selectingEnd(): never returned to the application
+#define NEXT_FRAME			0xFF
+
+// Antenna off time of RF reset, cards in the field lose power,
+// then power-up time of the cards before the next frame (ISO 14443-3 allows 5ms)
+#define RF_RESET_US			5000
+#define FIELD_GUARD_US		5000
+
+// SPI loopback test of mfrc522_negotiateClock(): rounds of a full FIFO
+// of pseudo-random bytes, written and read back in chunks
+#define FIFO_SIZE			64
+#define LOOPBACK_CHUNK		16
+#define LOOPBACK_ROUNDS		4
+
+// Digital self-test, see datasheet ch. 16.1.1
+#define SELFTEST_BUFFER		25 // internal buffer, cleared through Mem command
+#define SELFTEST_DEADLINE_US	1000
+#define AUTOTEST_SELFTEST	0x09
+#define AUTOTEST_RESET		0x40
+#define PING_PATTERN		0x55 // then its complement
+
+// Steps of mfrc522_recover()
+#define RECOVER_CANCEL		0
+#define RECOVER_RF_RESET	1
+#define RECOVER_SOFT_RESET	2
+#define RECOVER_HARD_RESET	3
+
+// Registers set by configuration profiles, in write order: antenna is turned on last.
+// Timer is the same in every profile, mfrc522_setTimeout() relies on it.
+#define PROFILE_SIZE	14
+#define PROFILE_TXMODE		6
+#define PROFILE_RXTHRESHOLD	9
+#define PROFILE_RFCFG		10
+#define PROFILE_CWGSP		11
+#define PROFILE_MODGSP		12
+#define PROFILE_TXCONTROL	(PROFILE_SIZE - 1)
+#define PROFILE_RESET	PROFILE_COUNT // state after soft reset, see datasheet ch. 9.3
+
+// Reset values of RF front-end registers that profiles leave alone
+#define DEMOD_RESET		0x4D
+#define GSN_RESET		0x88
+
+static const uint8_t PROFILE_REGISTERS[PROFILE_SIZE] PROGMEM = {
+	TModeReg, TPrescalerReg, TReloadRegH, TReloadRegL,
+	TxASKReg, ModeReg, TxModeReg, RxModeReg, ModWidthReg,
+	RxThresholdReg, RFCfgReg, CWGsPReg, ModGsPReg, TxControlReg
+};
+
+static const uint8_t PROFILES[PROFILE_COUNT + 1][PROFILE_SIZE] PROGMEM = {
+	// f_timer = 40kHz, reload every 50ms, 100% ASK, CRC preset 0x6363
+	// (ISO 14443-3 part 6.2.4), 106 kbit/s, RxGain 33dB, TX1 and TX2 on
+	[PROFILE_DEFAULT] = {
+		0x80, 0xA9, DEFAULT_TIMEOUT >> 8, DEFAULT_TIMEOUT & 0xFF,
+		0x40, 0x3D, 0x00, 0x00, 0x26,
+		0x84, 0x48, 0x20, 0x20, 0x83
+	},
+
+	// RxGain 48dB, lower MinLevel/CollLevel, maximum conductance of TX drivers
+	[PROFILE_LONG_RANGE] = {
+		0x80, 0xA9, DEFAULT_TIMEOUT >> 8, DEFAULT_TIMEOUT & 0xFF,
+		0x40, 0x3D, 0x00, 0x00, 0x26,
+		0x55, 0x70, 0x3F, 0x20, 0x83
+	},
+
+	// Reduced conductance of TX drivers, lower field strength and current
+	[PROFILE_LOW_POWER] = {
+		0x80, 0xA9, DEFAULT_TIMEOUT >> 8, DEFAULT_TIMEOUT & 0xFF,
+		0x40, 0x3D, 0x00, 0x00, 0x26,
+		0x84, 0x48, 0x08, 0x08, 0x83
+	},
+
+	// 212 kbit/s both directions, Miller pulse width for 212 kbit/s
+	[PROFILE_HIGH_BIT_RATE] = {
+		0x80, 0xA9, DEFAULT_TIMEOUT >> 8, DEFAULT_TIMEOUT & 0xFF,
+		0x40, 0x3D, 0x10, 0x10, 0x15,
+		0x84, 0x48, 0x20, 0x20, 0x83
+	},
+
+	[PROFILE_RESET] = {
+		0x00, 0x00, 0x00, 0x00,
+		0x00, 0x3F, 0x00, 0x00, 0x26,
+		0x84, 0x48, 0x20, 0x20, 0x80
+	}
+};
+
+// Output of the self-test per chip version, datasheet ch. 16.1.1
+static const uint8_t SELFTEST_VERSIONS[] PROGMEM = {0x91, 0x92};
+
+static const uint8_t SELFTEST_REFERENCES[][FIFO_SIZE] PROGMEM = {
+	// MFRC522 v1.0
+	{
+		0x00, 0xC6, 0x37, 0xD5, 0x32, 0xB7, 0x57, 0x5C,
+		0xC2, 0xD8, 0x7C, 0x4D, 0xD9, 0x70, 0xC7, 0x73,
+		0x10, 0xE6, 0xD2, 0xAA, 0x5E, 0xA1, 0x3E, 0x5A,
+		0x14, 0xAF, 0x30, 0x61, 0xC9, 0x70, 0xDB, 0x2E,
+		0x64, 0x22, 0x72, 0xB5, 0xBD, 0x65, 0xF4, 0xEC,
+		0x22, 0xBC, 0xD3, 0x72, 0x35, 0xCD, 0xAA, 0x41,
+		0x1F, 0xA7, 0xF3, 0x53, 0x14, 0xDE, 0x7E, 0x02,
+		0xD9, 0x0F, 0xB5, 0x5E, 0x25, 0x1D, 0x29, 0x79
+	},
+
+	// MFRC522 v2.0
+	{
+		0x00, 0xEB, 0x66, 0xBA, 0x57, 0xBF, 0x23, 0x95,
+		0xD0, 0xE3, 0x0D, 0x3D, 0x27, 0x89, 0x5C, 0xDE,
+		0x9D, 0x3B, 0xA7, 0x00, 0x21, 0x5B, 0x89, 0x82,
+		0x51, 0x3A, 0xEB, 0x02, 0x0C, 0xA5, 0x00, 0x49,
+		0x7C, 0x84, 0x4D, 0xB3, 0xCC, 0xD2, 0x1B, 0x81,
+		0x5D, 0x48, 0x76, 0xD5, 0x71, 0x61, 0x21, 0xA9,
+		0x86, 0x96, 0x83, 0x38, 0xCF, 0x9D, 0x5B, 0x6D,
+		0xDC, 0x15, 0xBA, 0x3E, 0x7D, 0x95, 0x3B, 0x2F
+	}
+};
+
+static uint8_t profile = PROFILE_RESET;
+
+// RF front-end override of every profile
+static RFTuning_t tuning;
+static bool tuned;
+
+// Soft power-down state and low-power polling, window is 0 if disabled
+static bool asleep;
+static uint16_t guard;
+static uint16_t window;
+
+// Timer reload of current command, deadlines of waits derive from it
+static uint16_t timeout = DEFAULT_TIMEOUT;
+
+// First step of next recovery, back to cancel once a wait ends in time
+static uint8_t rung;
+static RecoveryStats_t recovery;
+
+// Retry policy, and retries of the current mfrc522_getID() or mfrc522_readBlock()
+static RetryPolicy_t policy;
+static RetryStats_t retries;
+static uint8_t attempt;
+
+// xorshift32 state, every loopback test sends new patterns
+static uint32_t pattern = 0x9E3779B9UL;
+
+// Health checks
+static Health_t health;
+
+// Card tracked by mfrc522_monitorPresence()
+static UID_t tracked;
+static bool tracking;
+
+#ifndef MFRC522_SS_PORT
+// Reader whose state is in use, see mfrc522_useReader(), NULL if not set up as one
+static RFIDReader_t *current;
+
+// Readers of mfrc522_pollReaders() and mfrc522_getIDs(), bits of their results
+#define OVERLAP_READERS	8
+
+// Returned by mfrc522_overlapNext() at the end of a round while readers are deferred
+#define OVERLAP_ROUND	0xFF
+
+// Commands in flight on several readers, see mfrc522_overlapNext()
+typedef struct Overlap {
+	RFIDReader_t *readers;
+	uint8_t count;
+	uint8_t pending; // bit i set while a command of reader i runs
+	uint8_t deferred; // bit i set while reader i waits to start its next command
+	uint8_t turn; // reader polled next
+	bool ended; // a command ended during this round over the readers
+	uint16_t busy; // busy polls left, see mfrc522_waitIRq()
+	uint32_t waited; // time of paced polls, in us
+	uint32_t started[OVERLAP_READERS]; // waited as the command of each reader started
+#ifdef MFRC522_STATS
+	uint32_t begun[OVERLAP_READERS];
+	uint16_t polled[OVERLAP_READERS];
+#endif
+} Overlap_t;
+
+// Anticollision and SELECT of the card of one reader, see mfrc522_getIDs()
+typedef struct Selecting {
+	uint8_t frame[9]; // SELECT frame of the cascade level
+	uint8_t level;
+	uint8_t knownBits; // UID bits already resolved
+	uint8_t known; // known bits of the partial byte, as sent
+	uint8_t loops; // anticollision frames left
+	uint8_t count; // frame retries of the current step
+	uint8_t attempt; // see mfrc522_backoff()
+	uint32_t notBefore; // waited of Overlap_t before the next frame, after a retry
+	uint8_t status; // result, once done
+	bool select; // SELECT sent, else anticollision
+} Selecting_t;
+#endif
+
+// Frames used by presence check, with precomputed CRC_A
+static const uint8_t READ_BLOCK0[4] = {MIFARE_CMD_READ, 0x00, 0x02, 0xA8};
+static const uint8_t HALTA[4] = {MIFARE_CMD_HALT, 0x00, 0x57, 0xCD};
+
+// SELECT/ANTICOLLISION command of each cascade level
+static const uint8_t CASCADE_SEL[3] = {MIFARE_CMD_SELECTCL1,
+										MIFARE_CMD_SELECTCL2,
+										MIFARE_CMD_SELECTCL3};
+
+static void mfrc522_write(uint8_t register, uint8_t data);
+static void mfrc522_writeFIFO(const void *buffer, uint16_t size);
+static uint8_t mfrc522_read(uint8_t register);
+static void mfrc522_readFIFO(void *buffer, uint16_t size, void *tail, uint8_t tailSize);
+static void	mfrc522_setRegister(uint8_t reg, uint8_t bits, uint8_t value);
+static uint8_t mfrc522_softReset();
+static uint8_t mfrc522_waitReady();
+static uint8_t mfrc522_waitStartup();
+static bool mfrc522_checkVersion();
+static bool mfrc522_knownVersion(uint8_t version);
+static bool mfrc522_warmStart();
+static void mfrc522_setTimeout(uint16_t reload);
+static uint8_t mfrc522_waitIRq(uint8_t reg, uint8_t mask, uint32_t deadline);
+static bool mfrc522_healthy();
+static void mfrc522_configure();
+static void mfrc522_fieldReset();
+static void mfrc522_applyTuning(const RFTuning_t *values);
+static bool mfrc522_loopback();
+static uint8_t mfrc522_pattern();
+static uint8_t mfrc522_digitalTest(uint8_t version);
+static bool mfrc522_retryable(uint8_t status);
+static bool mfrc522_retryFrame(RetryStep_t step, uint8_t *count, uint8_t status);
+static bool mfrc522_retryCount(RetryStep_t step, uint8_t *count, uint8_t status);
+static void mfrc522_backoff();
+static uint16_t mfrc522_backoffDelay();
+static void mfrc522_retryEnd(uint8_t status);
+static uint8_t mfrc522_readID(UID_t *uid);
+static uint8_t mfrc522_restartID(UID_t *uid, uint8_t status);
+static uint8_t mfrc522_reselect(const UID_t *uid);
+static uint8_t mfrc522_transceiveAck(const void *txBuffer, uint8_t txSize);
+static uint8_t mfrc522_execute(uint8_t command, uint8_t waitIRq,
+								const void *txBuffer, uint8_t txSize, uint8_t txLastBits,
+								RFIDFrame_t *rx, uint8_t rxAlign, bool checkCRC);
+static void mfrc522_start(uint8_t command, const void *txBuffer, uint8_t txSize, uint8_t bitFraming);
+static uint8_t mfrc522_finish(uint8_t irqStatus, uint8_t waitIRq, RFIDFrame_t *rx, bool checkCRC);
+static uint8_t mfrc522_receive(RFIDFrame_t *rx, uint8_t errorStatus, bool checkCRC);
+static uint16_t mfrc522_crcA(uint16_t crc, const uint8_t *data, uint8_t size);
+static uint8_t mfrc522_calculateCRC(const void *buffer, uint8_t size, void *crc, bool *result);
+#ifndef MFRC522_SS_PORT
+static void mfrc522_saveReader(RFIDReader_t *reader);
+static void mfrc522_loadReader(const RFIDReader_t *reader);
+static void mfrc522_overlapStart(Overlap_t *overlap, uint8_t i, uint8_t command,
+									const void *txBuffer, uint8_t txSize, uint8_t bitFraming);
+static uint8_t mfrc522_overlapNext(Overlap_t *overlap, uint8_t *irq);
+static void mfrc522_overlapEnd(Overlap_t *overlap, uint8_t i, uint8_t command,
+								const void *txBuffer, uint8_t txSize, uint8_t status);
+static void mfrc522_selectingBegin(Selecting_t *selecting, uint8_t level);
+static void mfrc522_selectingStart(Overlap_t *overlap, uint8_t i, Selecting_t *selecting);
+static uint8_t mfrc522_selectingEnd(Overlap_t *overlap, uint8_t i, Selecting_t *selecting,
+									UID_t *uid, uint8_t irq);
+static bool mfrc522_retryLater(Overlap_t *overlap, RetryStep_t step, Selecting_t *selecting,
+								uint8_t status);
+#endif
+
+
+//! \brief Send command to MFRC522 reader.
+//! \param [in] command Command to MFRC522 reader, see MFRC522's datasheet ch. 10.3
+//! \param [in] waitIRq Interrupt request bits.
+//! \param [in] txBuffer Data buffer to be written.
+//! \param [in] txSize The size of data buffer.
+//! \param [in] txLastBits The number of valid bits in the last transmitted byte, 0 if all 8.
+//! \param [in,out] rx Caller buffer of received data, see RFIDFrame_t, NULL if not required.
+//! \param [in] rxAlign Bit position of the first received bit (RxAlign).
+//! \param [in] checkCRC Require CRC verification or not.
+//! \return 0 if success, > 0 if error has occured.
+//!
+static uint8_t mfrc522_command(uint8_t command,
+								uint8_t waitIRq,
+								const void *txBuffer,
+								uint8_t txSize,
+								uint8_t txLastBits,
+								RFIDFrame_t *rx,
+								uint8_t rxAlign,
+								bool checkCRC);
+
+//! \brief Compute and verify CRC if required.
+//! \param [in] rxBuffer Pointer to data buffer that we need compute CRC.
+//! \param [in] size The size of data buffer, in bytes.
+//! \param [out] crc Pointer to variable containing CRC value.
+//! \param [out] result If CRC value of __buffer is valid, result=true.
+//! pass NULL if do not require verify CRC.
+//! \return 0 if success, > 0 if error has occured.
+//!
+static uint8_t mfrc522_computeAndCheckCRC(const void *rxBuffer, 
+											uint8_t rxSize, 
+											void *crc,
+											bool *result);
+static uint8_t mfrc522_sendRequestWakeup(uint8_t command);
+static uint8_t mfrc522_sendREQA();
+uint8_t mfrc522_sendWUPA();
+
+
+//! \brief Send SELECT command to MIFARE card.
+//! \param [in,out] frame 9-byte SELECT frame: SEL, then a part of UID and BCC
+//! from bytes 2 to 6, NVB and CRC_A are filled in.
+//! \param [out] sak SAK returned from MIFARE card.
+//! \return 0 if success, > 0 if error has occured.
+//!
+static uint8_t mfrc522_select(uint8_t *frame, uint8_t *sak);
+
+
+//! \brief Send ANTICOLLISION command to MIFARE card.
+//! \param [in,out] frame 9-byte SELECT frame, starting with SEL: the part of UID
+//! and BCC returned from MIFARE card are received in place, from byte 2.
+//! \return 0 if success, > 0 if error has occured.
+//!
+static uint8_t mfrc522_anticollision(uint8_t *frame);
+
+
+//! \brief Set NVB of the next ANTICOLLISION frame.
+//! \param [in,out] frame 9-byte SELECT frame.
+//! \param knownBits The number of UID bits already resolved.
+//! \return The size of the frame to send, the last byte partial if knownBits % 8.
+//!
+static uint8_t mfrc522_anticollisionFrame(uint8_t *frame, uint8_t knownBits);
+
+
+//! \brief Check the answer to an ANTICOLLISION frame, and resolve a collision.
+//! \param [in,out] frame 9-byte SELECT frame, the answer received in place.
+//! \param [in,out] knownBits The number of UID bits already resolved, moved
+//! past the collision.
+//! \param known Known bits of the partial byte, as sent.
+//! \param status Status of the frame.
+//! \param rxSize The number of bytes received.
+//! \return 0 once UID and BCC are complete, NEXT_FRAME to send the next frame,
+//! STATUS_COLLISION if it cannot be resolved, > 0 for other errors.
+//!
+static uint8_t mfrc522_anticollisionAnswer(uint8_t *frame, uint8_t *knownBits, uint8_t known,
+											uint8_t status, uint8_t rxSize);
+ 
+
+uint8_t mfrc522_init() {
+	// Release MFRC522 Reader from hard power-down, no-op if it kept power
+	mfrc522_port_hardReset();
+	asleep = false;
+
+	if (mfrc522_warmStart()) {
+		return STATUS_OK;
+	}
+
+	// Oscillator may be starting after hard power-down
+	uint8_t status = mfrc522_waitStartup();
+
+	if (status == STATUS_OK) {
+		status = mfrc522_softReset();
+	}
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	// Configurate timer, transmitter and receiver, then turn antenna on
+	profile = PROFILE_RESET;
+	mfrc522_setProfile(PROFILE_DEFAULT);
+
+	return STATUS_OK;
+}
+
+
+uint8_t mfrc522_bringUp() {
+	mfrc522_port_setClock(0);
+
+	uint8_t status = mfrc522_init();
+
+	if (status == STATUS_OK && mfrc522_negotiateClock() == 0) {
+		status = STATUS_ERROR;
+	}
+
+	return status;
+}
+
+
+bool mfrc522_warmStart() {
+	if (!mfrc522_checkVersion()) {
+		return false;
+	}
+
+	// Oscillator is starting, or was stopped by mfrc522_powerDown() before MCU reset:
+	// leave soft power-down, a write during startup is ignored.
+	if (mfrc522_read(CommandReg) & BIT_4) {
+		mfrc522_write(CommandReg, MFRC522_CMD_IDLE);
+		return false;
+	}
+
+	// Signature: registers of one of the profiles are still set,
+	// they are back to reset values after power loss or reset.
+	uint8_t values[PROFILE_SIZE];
+
+	for (uint8_t i = 0; i < PROFILE_SIZE; i++) {
+		values[i] = mfrc522_read(pgm_read_byte(&PROFILE_REGISTERS[i]));
+	}
+
+	for (uint8_t next = 0; next < PROFILE_COUNT; next++) {
+		uint8_t i = 0;
+
+		while (i < PROFILE_SIZE && values[i] == pgm_read_byte(&PROFILES[next][i])) {
+			i++;
+		}
+
+		if (i == PROFILE_SIZE) {
+			// Stop whatever was running before MCU reset
+			mfrc522_write(CommandReg, MFRC522_CMD_IDLE);
+			mfrc522_stopCrypto();
+			profile = next;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+bool mfrc522_checkVersion() {
+	return mfrc522_knownVersion(mfrc522_read(VersionReg));
+}
+
+
+bool mfrc522_knownVersion(uint8_t version) {
+	// Absent reader reads 0x00 or 0xFF
+	switch (version) {
+		case 0x91: case 0x92: // MFRC522 v1.0, v2.0
+		case 0x88: case 0x12: case 0xB2: // compatible clones
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+
+void mfrc522_setProfile(RFIDProfile_t next) {
+	if (next >= PROFILE_COUNT) {
+		return;
+	}
+
+	// Only registers that differ from current profile are written
+	for (uint8_t i = 0; i < PROFILE_SIZE; i++) {
+		uint8_t value = pgm_read_byte(&PROFILES[next][i]);
+
+		if (value != pgm_read_byte(&PROFILES[profile][i])) {
+			mfrc522_write(pgm_read_byte(&PROFILE_REGISTERS[i]), value);
+		}
+	}
+
+	profile = next;
+
+	if (tuned) {
+		mfrc522_applyTuning(&tuning);
+	}
+}
+
+
+RFIDProfile_t mfrc522_getProfile() {
+	return profile;
+}
+
+
+void mfrc522_setTuning(const RFTuning_t *values) {
+	tuned = false;
+
+	if (values) {
+		tuning = *values;
+		tuned = true;
+	}
+
+	// Before mfrc522_init(), applied with the first profile
+	if (profile == PROFILE_RESET) {
+		return;
+	}
+
+	RFTuning_t applied;
+
+	mfrc522_getTuning(&applied);
+	mfrc522_applyTuning(&applied);
+}
+
+
+bool mfrc522_getTuning(RFTuning_t *values) {
+	if (tuned) {
+		*values = tuning;
+		return true;
+	}
+
+	values->rxGain = pgm_read_byte(&PROFILES[profile][PROFILE_RFCFG]);
+	values->rxThreshold = pgm_read_byte(&PROFILES[profile][PROFILE_RXTHRESHOLD]);
+	values->demod = DEMOD_RESET;
+	values->cwGsP = pgm_read_byte(&PROFILES[profile][PROFILE_CWGSP]);
+	values->modGsP = pgm_read_byte(&PROFILES[profile][PROFILE_MODGSP]);
+	values->gsN = GSN_RESET;
+
+	return false;
+}
+
+
+void mfrc522_powerDown() {
+	if (asleep) {
+		return;
+	}
+
+	// TX1 and TX2 off, then PowerDown bit with Idle command
+	mfrc522_write(TxControlReg, pgm_read_byte(&PROFILES[profile][PROFILE_TXCONTROL]) & ~0x03);
+	mfrc522_write(CommandReg, BIT_4 | MFRC522_CMD_IDLE);
+
+	asleep = true;
+	STATS_SLEEP();
+}
+
+
+uint8_t mfrc522_wakeUp() {
+	if (!asleep) {
+		return STATUS_OK;
+	}
+
+	STATS_WAKE_BEGIN();
+
+	// Clearing PowerDown bit restarts the oscillator
+	mfrc522_write(CommandReg, MFRC522_CMD_IDLE);
+
+	uint8_t status = mfrc522_waitReady();
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	asleep = false;
+	STATS_WAKE();
+
+	// Field on, cards in the field power up from reset
+	mfrc522_write(TxControlReg, pgm_read_byte(&PROFILES[profile][PROFILE_TXCONTROL]));
+
+	if (guard) {
+		mfrc522_port_delayUs(guard);
+	}
+
+	return STATUS_OK;
+}
+
+
+void mfrc522_setLowPower(const LowPower_t *config) {
+	if (config == NULL) {
+		window = 0;
+		mfrc522_wakeUp();
+		return;
+	}
+
+	guard = config->guard;
+	window = config->window / TIMER_TICK_US;
+
+	// At least one timer period
+	if (window == 0) {
+		window = 1;
+	}
+
+	mfrc522_powerDown();
+}
+
+
+uint8_t mfrc522_softReset() {
+	mfrc522_write(CommandReg, MFRC522_CMD_SOFTRESET);
+	mfrc522_port_delayUs(READY_INTERVAL_US); // PowerDown bit is set once reset has started
+
+	return mfrc522_waitReady();
+}
+
+
+uint8_t mfrc522_waitReady() {
+	// PowerDown bit in CommandReg is cleared when the oscillator is stable
+	for (uint16_t i = 0; i < READY_POLLS; i++) {
+		if (!(mfrc522_read(CommandReg) & BIT_4)) {
+			return STATUS_OK;
+		}
+
+		mfrc522_port_delayUs(READY_INTERVAL_US);
+	}
+
+	return STATUS_TIMEOUT;
+}
+
+
+uint8_t mfrc522_waitStartup() {
+	// As mfrc522_waitReady() after RST release: MISO reads 0x00 until the
+	// reader answers, a cleared PowerDown bit alone does not tell it is up.
+	bool known = false;
+
+	for (uint16_t i = 0; i < READY_POLLS; i++) {
+		known = mfrc522_checkVersion();
+
+		if (known && !(mfrc522_read(CommandReg) & BIT_4)) {
+			return STATUS_OK;
+		}
+
+		mfrc522_port_delayUs(READY_INTERVAL_US);
+	}
+
+	return known ? STATUS_TIMEOUT : STATUS_ERROR;
+}
+
+
+uint8_t mfrc522_recover() {
+	for (uint8_t step = rung; step <= RECOVER_HARD_RESET; step++) {
+		switch (step) {
+			case RECOVER_CANCEL:
+				mfrc522_write(CommandReg, MFRC522_CMD_IDLE);
+				mfrc522_write(BitFramingReg, 0);
+				break;
+
+			case RECOVER_RF_RESET:
+				mfrc522_fieldReset();
+				break;
+
+			case RECOVER_SOFT_RESET:
+				if (mfrc522_softReset() == STATUS_OK) {
+					mfrc522_configure();
+				}
+				break;
+
+			case RECOVER_HARD_RESET:
+				mfrc522_port_resetPulse();
+
+				if (mfrc522_waitStartup() == STATUS_OK) {
+					mfrc522_configure();
+				}
+				break;
+		}
+
+		if (mfrc522_healthy()) {
+			uint16_t *counters[] = {&recovery.cancels, &recovery.rfResets,
+									&recovery.softResets, &recovery.hardResets};
+
+			(*counters[step])++;
+			rung = (step < RECOVER_HARD_RESET) ? step + 1 : RECOVER_HARD_RESET;
+			return STATUS_OK;
+		}
+	}
+
+	recovery.failures++;
+	rung = RECOVER_HARD_RESET;
+
+	return STATUS_ERROR;
+}
+
+
+void mfrc522_getRecoveryStats(RecoveryStats_t *stats) {
+	*stats = recovery;
+}
+
+
+void mfrc522_resetRecoveryStats() {
+	recovery = (RecoveryStats_t){0};
+}
+
+
+uint32_t mfrc522_negotiateClock() {
+	uint8_t passed = 0;
+	bool failed = false;
+
+	for (uint8_t step = 0; mfrc522_port_setClock(step); step++) {
+		if (!mfrc522_loopback()) {
+			failed = true;
+			break;
+		}
+
+		passed = step + 1;
+	}
+
+	if (passed == 0) {
+		mfrc522_port_setClock(0);
+		return 0;
+	}
+
+	// Margin: one step below the fastest clock that passed, unless all passed
+	uint32_t clock = mfrc522_port_setClock((failed && passed > 1) ? passed - 2 : passed - 1);
+
+	// Garbled transfers may have written to any register
+	if (failed) {
+		if (mfrc522_softReset() != STATUS_OK) {
+			return 0;
+		}
+
+		mfrc522_configure();
+	}
+
+	return mfrc522_loopback() ? clock : 0;
+}
+
+
+bool mfrc522_verifyClock() {
+	if (mfrc522_loopback()) {
+		return true;
+	}
+
+	mfrc522_negotiateClock();
+
+	return false;
+}
+
+
+uint8_t mfrc522_ping() {
+	uint8_t status = STATUS_OK;
+
+	health.version = mfrc522_read(VersionReg);
+
+	if (!mfrc522_knownVersion(health.version)) {
+		status = STATUS_ERROR;
+	}
+
+	// A pattern and its complement catch bits stuck at 0 and at 1
+	uint8_t value = PING_PATTERN;
+
+	for (uint8_t i = 0; i < 2 && status == STATUS_OK; i++, value = ~value) {
+		mfrc522_write(TReloadRegL, value);
+
+		if (mfrc522_read(TReloadRegL) != value) {
+			status = STATUS_ERROR;
+		}
+	}
+
+	mfrc522_write(TReloadRegL, timeout & 0xFF);
+
+	health.ping = status;
+	health.pings++;
+
+	if (status != STATUS_OK) {
+		health.pingFailures++;
+	}
+
+	return status;
+}
+
+
+uint8_t mfrc522_selfTest() {
+	uint8_t status = STATUS_ERROR;
+
+	health.version = mfrc522_read(VersionReg);
+
+	if (mfrc522_knownVersion(health.version) && mfrc522_softReset() == STATUS_OK) {
+		status = mfrc522_digitalTest(health.version);
+	}
+
+	// Test mode off, the FIFO holds its output: back to the configuration in use
+	mfrc522_write(CommandReg, MFRC522_CMD_IDLE);
+	mfrc522_write(AutoTestReg, AUTOTEST_RESET);
+
+	if (mfrc522_softReset() == STATUS_OK) {
+		mfrc522_configure();
+	}
+	else {
+		status = STATUS_ERROR;
+	}
+
+	health.selfTest = status;
+	health.selfTests++;
+
+	if (status != STATUS_OK && status != STATUS_INVALID) {
+		health.selfTestFailures++;
+	}
+
+	return status;
+}
+
+
+void mfrc522_getHealth(Health_t *stats) {
+	*stats = health;
+}
+
+
+void mfrc522_resetHealth() {
+	health = (Health_t){0};
+}
+
+
+void mfrc522_setRetryPolicy(const RetryPolicy_t *config) {
+	if (config == NULL) {
+		policy = (RetryPolicy_t){{0}};
+		return;
+	}
+
+	policy = *config;
+}
+
+
+void mfrc522_getRetryStats(RetryStats_t *stats) {
+	*stats = retries;
+}
+
+
+void mfrc522_resetRetryStats() {
+	retries = (RetryStats_t){0};
+}
+
+
+uint8_t mfrc522_command(uint8_t command,
+						uint8_t waitIRq,
+						const void *txBuffer,
+						uint8_t txSize,
+						uint8_t txLastBits,
+						RFIDFrame_t *rx,
+						uint8_t rxAlign,
+						bool checkCRC) {
+
+	// Reader is powered down between low-power polls
+	if (asleep) {
+		uint8_t status = mfrc522_wakeUp();
+
+		if (status != STATUS_OK) {
+			return status;
+		}
+	}
+
+	TRACE(TRACE_BEGIN | command, txSize);
+	STATS_BEGIN();
+
+	uint8_t status = mfrc522_execute(command, waitIRq, txBuffer, txSize, txLastBits,
+									rx, rxAlign, checkCRC);
+
+	STATS_END(command, txBuffer, txSize, status);
+	TRACE(TRACE_END | command, status);
+
+	return status;
+}
+
+
+uint8_t mfrc522_execute(uint8_t command,
+						uint8_t waitIRq,
+						const void *txBuffer,
+						uint8_t txSize,
+						uint8_t txLastBits,
+						RFIDFrame_t *rx,
+						uint8_t rxAlign,
+						bool checkCRC) {
+
+	mfrc522_start(command, txBuffer, txSize, (rxAlign << 4) | txLastBits);
+
+	// Wait for the command execution to complete, or for TimerIRq.
+	uint8_t irqStatus = mfrc522_waitIRq(ComIrqReg, waitIRq | 0x01,
+										(uint32_t)timeout * TIMER_TICK_US + FRAME_MARGIN_US);
+
+	return mfrc522_finish(irqStatus, waitIRq, rx, checkCRC);
+}
+
+
+void mfrc522_start(uint8_t command, const void *txBuffer, uint8_t txSize, uint8_t bitFraming) {
+	mfrc522_setRegister(ComIrqReg, BIT_7, 0); // Clear all interrupt request bits
+	mfrc522_setRegister(FIFOLevelReg, BIT_7, BIT_7); // immediately clear the internal FIFO 
+	mfrc522_write(CommandReg, MFRC522_CMD_IDLE); // Cancel current command execution
+	mfrc522_writeFIFO(txBuffer, txSize); // Write data to FIFO
+
+	mfrc522_write(BitFramingReg, bitFraming); //
+	mfrc522_write(CommandReg, command);
+
+	// Start the transmission of data
+	if (command == MFRC522_CMD_TRANSCEIVE) {
+		mfrc522_setRegister(BitFramingReg, BIT_7, BIT_7);
+	}
+}
+
+
+uint8_t mfrc522_finish(uint8_t irqStatus, uint8_t waitIRq, RFIDFrame_t *rx, bool checkCRC) {
+	if (irqStatus == 0) {
+		return STATUS_HUNG;
+	}
+
+	if (!(irqStatus & waitIRq)) {
+		return STATUS_TIMEOUT;
+	}
+
+	uint8_t errorStatus = mfrc522_read(ErrorReg);
+
+	// Return STATUS_ERROR for [BufferOvfl, ParityErr and ProtocolErr]
+	if (errorStatus & 0x13) {
+		return STATUS_ERROR;
+	}
+
+	// Read rx data if user required,
+	// even after a collision since anticollision needs the valid bits.
+	if (rx) {
+		return mfrc522_receive(rx, errorStatus, checkCRC);
+	}
+
+	// Return STATUS_COLLISION for CollErr
+	if (errorStatus & 0x08) {
+		return STATUS_COLLISION;
+	}
+
+	return STATUS_OK;
+}
+
+
+uint8_t mfrc522_receive(RFIDFrame_t *rx, uint8_t errorStatus, bool checkCRC) {
+	uint8_t size = mfrc522_read(FIFOLevelReg);
+
+	rx->lastBits = mfrc522_read(ControlReg) & 0x07; // Read control register for RxLastBits
+
+	// CRC_A is read into its own slice, in the same transfer as the payload
+	uint8_t crcSize = (checkCRC && size >= 2) ? 2 : 0;
+
+	if (size - crcSize > rx->capacity) {
+		return STATUS_NO_ROOM;
+	}
+
+	rx->size = size - crcSize;
+	mfrc522_readFIFO(rx->data, rx->size, rx->crc, crcSize);
+
+	// Return STATUS_COLLISION for CollErr
+	if (errorStatus & 0x08) {
+		return STATUS_COLLISION;
+	}
+
+	if (!checkCRC) {
+		return STATUS_OK;
+	}
+
+	// if MIFARE card NAK is not OK
+	if (size == 1 && rx->lastBits == 4) {
+		return STATUS_MIFARE_NACK;
+	}
+
+	// we need at least 2 bytes for CRC_A,
+	// which leaves a residue of 0 over the frame and its CRC_A
+	if (crcSize == 0 || rx->lastBits != 0
+		|| mfrc522_crcA(mfrc522_crcA(CRC_A_PRESET, rx->data, rx->size), rx->crc, 2) != 0) {
+		return STATUS_CRC_WRONG;
+	}
+
+	return STATUS_OK;
+}
+
+
+uint8_t mfrc522_transceiveFrame(const void *txBuffer, uint8_t txSize, RFIDFrame_t *rx, bool checkCRC) {
+	return mfrc522_command(MFRC522_CMD_TRANSCEIVE,
+							0x30,
+							txBuffer,
+							txSize,
+							0,
+							rx,
+							0,
+							checkCRC);
+}
+
+
+uint8_t mfrc522_transceiveRaw(const void *txBuffer, uint8_t txSize,
+								const RFIDFraming_t *framing, RFIDFrame_t *rx) {
+
+	// TxLastBits and RxAlign of BitFramingReg are 3 bits wide
+	if (framing->txLastBits > 7 || framing->rxAlign > 7) {
+		return STATUS_INVALID;
+	}
+
+	// Registers are written while awake only
+	if (asleep) {
+		uint8_t status = mfrc522_wakeUp();
+
+		if (status != STATUS_OK) {
+			return status;
+		}
+	}
+
+	uint16_t reload = timeout;
+	uint8_t txMode = pgm_read_byte(&PROFILES[profile][PROFILE_TXMODE]);
+
+	if (framing->timeout) {
+		mfrc522_setTimeout(((uint32_t)framing->timeout + TIMER_TICK_US - 1) / TIMER_TICK_US);
+	}
+
+	if (framing->txCRC) {
+		mfrc522_write(TxModeReg, txMode | BIT_7); // TxCRCEn
+	}
+
+	if (framing->noParity) {
+		mfrc522_write(MfRxReg, BIT_4); // ParityDisable
+	}
+
+	uint8_t status;
+
+	if (rx) {
+		status = mfrc522_command(MFRC522_CMD_TRANSCEIVE, 0x30, txBuffer, txSize,
+								framing->txLastBits, rx, framing->rxAlign, framing->rxCRC);
+	}
+	else {
+		status = mfrc522_command(MFRC522_CMD_TRANSMIT, BIT_6, txBuffer, txSize,
+								framing->txLastBits, NULL, 0, false);
+	}
+
+	if (framing->noParity) {
+		mfrc522_write(MfRxReg, 0);
+	}
+
+	if (framing->txCRC) {
+		mfrc522_write(TxModeReg, txMode);
+	}
+
+	if (framing->timeout) {
+		mfrc522_setTimeout(reload);
+	}
+
+	return status;
+}
+
+
+uint8_t mfrc522_sendRequestWakeup(uint8_t command) {
+	uint8_t ATQA[2];
+	RFIDFrame_t rx = {ATQA, sizeof(ATQA)};
+
+	mfrc522_setRegister(CollReg, BIT_7, 0); // all received bits will be cleared after a collision
+
+	// using short frame for REQA and WUPA command to RFID card.
+	uint8_t status = mfrc522_command(MFRC522_CMD_TRANSCEIVE, 0x30, &command, 1,
+									/* txLastBits = */ 7, &rx, 0, false);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	// ATQA must be exactly 16 bits.
+	if (rx.size != 2 || rx.lastBits != 0) {
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
+
+uint8_t mfrc522_sendREQA() {
+	return mfrc522_sendRequestWakeup(MIFARE_CMD_REQA);
+}
+
+
+uint8_t mfrc522_sendWUPA() {
+	return mfrc522_sendRequestWakeup(MIFARE_CMD_WUPA);
+}
+
+
+bool mfrc522_available() {
+	if (window == 0) {
+		return (mfrc522_sendREQA() == STATUS_OK);
+	}
+
+	// Low-power polling: awake for the REQA window only
+	if (mfrc522_wakeUp() != STATUS_OK) {
+		return false;
+	}
+
+	mfrc522_setTimeout(window);
+	bool available = (mfrc522_sendREQA() == STATUS_OK);
+	mfrc522_setTimeout(DEFAULT_TIMEOUT);
+
+	if (!available) {
+		mfrc522_powerDown();
+	}
+
+	return available;
+}
+
+#ifndef MFRC522_SS_PORT
+
+void mfrc522_attachReader(RFIDReader_t *reader, void *port) {
+	*reader = (RFIDReader_t){.port = port, .profile = PROFILE_RESET, .timeout = DEFAULT_TIMEOUT};
+
+	// Set up again: its state is the one above, not the one in use
+	if (current == reader) {
+		current = NULL;
+	}
+
+	mfrc522_useReader(reader);
+}
+
+
+void mfrc522_useReader(RFIDReader_t *reader) {
+	if (reader != current) {
+		if (current) {
+			mfrc522_saveReader(current);
+		}
+
+		mfrc522_loadReader(reader);
+		current = reader;
+	}
+
+	// Bound to another reader between polls of mfrc522_pollReaders()
+	mfrc522_port_bind(reader->port);
+}
+
+
+uint8_t mfrc522_pollReaders(RFIDReader_t *readers, uint8_t count) {
+	static const uint8_t REQA = MIFARE_CMD_REQA;
+	RFIDReader_t *previous = current;
+	Overlap_t overlap = {readers, count};
+	uint8_t ATQA[2];
+	uint8_t found = 0;
+
+	if (count > OVERLAP_READERS) {
+		return 0;
+	}
+
+	for (uint8_t i = 0; i < count; i++) {
+		mfrc522_useReader(&readers[i]);
+
+		// Low-power polling wakes the reader up for its own window
+		if (window) {
+			if (mfrc522_available()) {
+				found |= 1 << i;
+			}
+			continue;
+		}
+
+		if (asleep && mfrc522_wakeUp() != STATUS_OK) {
+			continue;
+		}
+
+		// As mfrc522_sendREQA(), without waiting for the answer
+		mfrc522_setRegister(CollReg, BIT_7, 0);
+		mfrc522_overlapStart(&overlap, i, MFRC522_CMD_TRANSCEIVE, &REQA, 1, /* txLastBits = */ 7);
+	}
+
+	while (overlap.pending) {
+		RFIDFrame_t rx = {ATQA, sizeof(ATQA)};
+		uint8_t irq;
+		uint8_t i = mfrc522_overlapNext(&overlap, &irq);
+		uint8_t status = mfrc522_finish(irq, 0x30, &rx, false);
+
+		// ATQA must be exactly 16 bits.
+		if (status == STATUS_OK && rx.size == 2 && rx.lastBits == 0) {
+			found |= 1 << i;
+		}
+
+		mfrc522_overlapEnd(&overlap, i, MFRC522_CMD_TRANSCEIVE, &REQA, 1, status);
+	}
+
+	if (previous) {
+		mfrc522_useReader(previous);
+	}
+
+	return found;
+}
+
+
+uint8_t mfrc522_getIDs(RFIDReader_t *readers, uint8_t count, uint8_t mask, UID_t *uids) {
+	RFIDReader_t *previous = current;
+	Overlap_t overlap = {readers, count};
+	Selecting_t selecting[OVERLAP_READERS];
+	uint8_t found = 0;
+
+	if (count > OVERLAP_READERS) {
+		return 0;
+	}
+
+	for (uint8_t i = 0; i < count; i++) {
+		if (!(mask & (1 << i))) {
+			continue;
+		}
+
+		mfrc522_useReader(&readers[i]);
+		selecting[i].attempt = 0;
+		selecting[i].notBefore = 0;
+		selecting[i].status = STATUS_OK;
+		uids[i].size = 0;
+
+		if (asleep) {
+			selecting[i].status = mfrc522_wakeUp();
+
+			if (selecting[i].status != STATUS_OK) {
+				continue;
+			}
+		}
+
+		// As mfrc522_readID(), one frame at a time
+		mfrc522_setRegister(CollReg, BIT_7, 0);
+		mfrc522_selectingBegin(&selecting[i], 0);
+		mfrc522_selectingStart(&overlap, i, &selecting[i]);
+	}
+
+	while (overlap.pending || overlap.deferred) {
+		uint8_t irq;
+		uint8_t i = mfrc522_overlapNext(&overlap, &irq);
+
+		// Retries whose back-off is over start, the other readers kept running
+		if (i == OVERLAP_ROUND) {
+			for (i = 0; i < count; i++) {
+				if ((overlap.deferred & (1 << i))
+					&& (int32_t)(overlap.waited - selecting[i].notBefore) >= 0) {
+					overlap.deferred &= ~(1 << i);
+					mfrc522_useReader(&readers[i]);
+					mfrc522_selectingStart(&overlap, i, &selecting[i]);
+				}
+			}
+			continue;
+		}
+
+		attempt = selecting[i].attempt;
+		uint8_t status = mfrc522_selectingEnd(&overlap, i, &selecting[i], &uids[i], irq);
+		selecting[i].attempt = attempt;
+
+		if (status == NEXT_FRAME && (int32_t)(overlap.waited - selecting[i].notBefore) < 0) {
+			overlap.deferred |= 1 << i;
+		}
+		else if (status == NEXT_FRAME) {
+			mfrc522_selectingStart(&overlap, i, &selecting[i]);
+		}
+		else {
+			selecting[i].status = status;
+		}
+	}
+
+	// Readers whose card was not read start over on their own, as mfrc522_getID()
+	for (uint8_t i = 0; i < count; i++) {
+		if (!(mask & (1 << i))) {
+			continue;
+		}
+
+		mfrc522_useReader(&readers[i]);
+		attempt = selecting[i].attempt;
+
+		if (mfrc522_restartID(&uids[i], selecting[i].status) == STATUS_OK) {
+			found |= 1 << i;
+		}
+	}
+
+	if (previous) {
+		mfrc522_useReader(previous);
+	}
+
+	return found;
+}
+
+#endif
+
+
+uint8_t mfrc522_select(uint8_t *frame, uint8_t *sak) {
+	RFIDFrame_t rx = {sak, 1};
+
+	frame[1] = 0x70; // NVB (Number of Valid Bits)
+
+	uint8_t status = mfrc522_computeAndCheckCRC(frame, 7, frame+7, NULL);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	uint8_t count = 0;
+
+	do {
+		status = mfrc522_transceiveFrame(frame, 9, &rx, true);
+	} while (status != STATUS_OK && mfrc522_retryFrame(RETRY_SELECT, &count, status));
+
+	return status;
+}
+
+
+uint8_t mfrc522_anticollision(uint8_t *frame) {
+	uint8_t status;
+	uint8_t knownBits = 0; // the number of UID bits already resolved
+	uint8_t counter = 32; // the maximum number of anticollision loops
+	uint8_t count = 0; // frame retries
+
+	while (counter--) {
+		uint8_t bytes = knownBits / 8;
+		uint8_t bits = knownBits % 8;
+		uint8_t known = frame[2+bytes] & ((1 << bits) - 1);
+
+		// The card sends the remaining UID bits into the frame, the first one
+		// is aligned right after the known bits of the last, partial byte.
+		// Room up to the end of the frame: a longer answer is a size error.
+		RFIDFrame_t rx = {frame + 2 + bytes, 7 - bytes};
+
+		status = mfrc522_command(MFRC522_CMD_TRANSCEIVE,
+								0x30,
+								frame,
+								mfrc522_anticollisionFrame(frame, knownBits),
+								/* txLastBits = */ bits,
+								&rx,
+								/* rxAlign = */ bits,
+								false);
+
+		status = mfrc522_anticollisionAnswer(frame, &knownBits, known, status, rx.size);
+
+		if (status == NEXT_FRAME) {
+			continue;
+		}
+
+		if (status == STATUS_OK || status == STATUS_COLLISION) {
+			return status;
+		}
+
+		if (!mfrc522_retryFrame(RETRY_ANTICOLLISION, &count, status)) {
+			return status;
+		}
+	}
+
+	return STATUS_COLLISION;
+}
+
+
+uint8_t mfrc522_anticollisionFrame(uint8_t *frame, uint8_t knownBits) {
+	uint8_t bytes = knownBits / 8;
+	uint8_t bits = knownBits % 8;
+
+	frame[1] = ((2 + bytes) << 4) | bits; // NVB (Number of Valid Bits)
+
+	return 2 + bytes + (bits ? 1 : 0);
+}
+
+
+uint8_t mfrc522_anticollisionAnswer(uint8_t *frame, uint8_t *knownBits, uint8_t known,
+									uint8_t status, uint8_t rxSize) {
+	uint8_t bytes = *knownBits / 8;
+	uint8_t mask = (1 << (*knownBits % 8)) - 1;
+
+	// Merge received bits with the known bits of the partial byte,
+	// which a failed receive may have overwritten.
+	frame[2+bytes] = known | (frame[2+bytes] & ~mask);
+
+	if (status == STATUS_OK || status == STATUS_COLLISION) {
+		status = (rxSize == 5 - bytes) ? status : STATUS_ERROR;
+	}
+
+	if (status != STATUS_OK && status != STATUS_COLLISION) {
+		return status;
+	}
+
+	if (status == STATUS_OK) {
+		// Check BCC, known bits of a partial byte are kept for a retry
+		if ((frame[2] ^ frame[3] ^ frame[4] ^ frame[5]) != frame[6]) {
+			return STATUS_ERROR;
+		}
+
+		return STATUS_OK;
+	}
+
+	status = mfrc522_read(CollReg);
+
+	// if collision position is not valid
+	if (status & BIT_5) {
+		return STATUS_COLLISION;
+	}
+
+	// CollPos counts from the first bit of the first received byte,
+	// 0 means the 32nd bit.
+	uint8_t coll_pos = status & 0x1F;
+
+	if (coll_pos == 0) {
+		coll_pos = 32;
+	}
+
+	coll_pos += bytes * 8;
+
+	if (coll_pos <= *knownBits || coll_pos > 32) {
+		return STATUS_COLLISION;
+	}
+
+	// Keep all bits before the collision, and choose the card(s)
+	// having 1 at the collision position.
+	*knownBits = coll_pos;
+	frame[2 + (coll_pos-1) / 8] |= 1 << ((coll_pos-1) % 8);
+
+	return NEXT_FRAME;
+}
+
+
+uint8_t mfrc522_getID(UID_t *uid) {
+	attempt = 0;
+
+	return mfrc522_restartID(uid, mfrc522_readID(uid));
+}
+
+
+uint8_t mfrc522_restartID(UID_t *uid, uint8_t status) {
+	uint8_t wakeups = 0;
+	uint8_t resets = 0;
+
+	// Start over with WUPA, which also wakes halted and half-selected cards,
+	// then with the cards powered up again by a field reset.
+	while (mfrc522_retryable(status)) {
+		if (wakeups < policy.wakeups) {
+			wakeups++;
+			retries.wakeups++;
+		}
+		else if (resets < policy.fieldResets) {
+			resets++;
+			retries.fieldResets++;
+			mfrc522_fieldReset();
+			mfrc522_port_delayUs(FIELD_GUARD_US);
+		}
+		else {
+			break;
+		}
+
+		mfrc522_backoff();
+		status = mfrc522_sendWUPA();
+
+		if (status == STATUS_OK) {
+			status = mfrc522_readID(uid);
+		}
+	}
+
+	mfrc522_retryEnd(status);
+
+	return status;
+}
+
+
+uint8_t mfrc522_readID(UID_t *uid) {
+	uint8_t status = 0;
+	uint8_t frame[9]; // SELECT frame, anticollision fills in UID and BCC
+	uint8_t sak = 0;
+	uint8_t size = 0;
+
+	mfrc522_setRegister(CollReg, BIT_7, 0); // all received bits will be cleared after a collision
+
+	for (uint8_t level = 0; ; level++) {
+		if (level == 3) {
+			return STATUS_INTERNAL_ERROR;
+		}
+
+		frame[0] = CASCADE_SEL[level];
+		status = mfrc522_anticollision(frame);
+
+		if (status != STATUS_OK) {
+			return status;
+		}
+
+		status = mfrc522_select(frame, &sak);
+
+		if (status != STATUS_OK) {
+			return status;
+		}
+
+		// Every cascade level but the last one starts with Cascade Tag.
+		bool cascade = sak & BIT_2;
+
+		for (uint8_t i = cascade ? 1 : 0; i < 4; i++) {
+			uid->UID[size++] = frame[2+i];
+		}
+
+		if (!cascade) {
+			break;
+		}
+	}
+
+	uid->size = size;
+	uid->SAK = sak;
+
+	return status;
+}
+
+uint8_t mfrc522_sendHaltA() {
+	uint8_t buffer[4];
+
+	buffer[0] = MIFARE_CMD_HALT;
+	buffer[1] = 0x00;
+
+	uint8_t status = mfrc522_computeAndCheckCRC(buffer, 2, buffer+2, NULL);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	status = mfrc522_transceiveFrame(buffer, 4, NULL, /* check CRC = */ false);
+
+	if (status == STATUS_TIMEOUT) 
+		return STATUS_OK;
+
+	if (status == STATUS_OK) 
+		return STATUS_ERROR;
+
+	return status;
+}
+
+
+bool mfrc522_checkPresence(const UID_t *uid) {
+	uint8_t buffer[18];
+	RFIDFrame_t rx = {buffer, sizeof(buffer)};
+	uint8_t status;
+
+	// A missing card is detected by timeout, so keep it short while probing.
+	mfrc522_setTimeout(PRESENCE_TIMEOUT);
+
+	if (uid->SAK == 0x00) {
+		// MIFARE Ultralight: READ page 0 is answered with 16 bytes + CRC_A,
+		// the card stays ACTIVE.
+		status = mfrc522_transceiveFrame(READ_BLOCK0, sizeof(READ_BLOCK0), &rx, false);
+
+		if (status == STATUS_OK && rx.size != 18) {
+			status = STATUS_ERROR;
+		}
+	}
+	else {
+		if (uid->SAK & BIT_3) {
+			// MIFARE Classic: unauthenticated READ is answered with a 4-bit NAK,
+			// the card falls back to IDLE.
+			status = mfrc522_transceiveFrame(READ_BLOCK0, sizeof(READ_BLOCK0), &rx, false);
+
+			if (status == STATUS_OK && (rx.size != 1 || rx.lastBits != 4)) {
+				status = STATUS_ERROR;
+			}
+		}
+		else {
+			// Other cards: HLTA needs no answer, so only transmit it.
+			status = mfrc522_command(MFRC522_CMD_TRANSMIT, BIT_6, HALTA, sizeof(HALTA), 0, NULL, 0, false);
+		}
+
+		// Bring the card back to ACTIVE without anticollision.
+		if (status == STATUS_OK) {
+			status = mfrc522_reselect(uid);
+		}
+	}
+
+	mfrc522_setTimeout(DEFAULT_TIMEOUT);
+
+	return (status == STATUS_OK);
+}
+
+
+PresenceEvent_t mfrc522_monitorPresence(UID_t *uid) {
+	if (!tracking) {
+		if (mfrc522_available() && mfrc522_getID(&tracked) == STATUS_OK) {
+			tracking = true;
+			*uid = tracked;
+			return PRESENCE_ARRIVED;
+		}
+
+		return PRESENCE_NONE;
+	}
+
+	*uid = tracked;
+
+	if (mfrc522_checkPresence(&tracked)) {
+		return PRESENCE_PRESENT;
+	}
+
+	// One missed probe may be noise. The card is IDLE or HALT now,
+	// so a plain reselect tells if it is still in the field.
+	mfrc522_setTimeout(PRESENCE_TIMEOUT);
+	bool present = (mfrc522_reselect(&tracked) == STATUS_OK);
+	mfrc522_setTimeout(DEFAULT_TIMEOUT);
+
+	if (present) {
+		return PRESENCE_PRESENT;
+	}
+
+	tracking = false;
+	return PRESENCE_REMOVED;
+}
+
+
+uint8_t mfrc522_reselect(const UID_t *uid) {
+	uint8_t levels;
+
+	switch (uid->size) {
+		case 4:		levels = 1; break;
+		case 7:		levels = 2; break;
+		case 10:	levels = 3; break;
+		default:	return STATUS_INVALID;
+	}
+
+	uint8_t status = mfrc522_sendWUPA();
+
+	// Several cards may answer WUPA at once,
+	// SELECT with the full UID still addresses only one of them.
+	if (status != STATUS_OK && status != STATUS_COLLISION) {
+		return status;
+	}
+
+	const uint8_t *id = uid->UID;
+	uint8_t frame[9];
+	uint8_t sak;
+
+	for (uint8_t level = 0; level < levels; level++) {
+		uint8_t i = 2;
+
+		frame[0] = CASCADE_SEL[level];
+
+		if (level < levels - 1) {
+			frame[i++] = 0x88; // Cascade Tag
+		}
+
+		while (i < 6) {
+			frame[i++] = *id++;
+		}
+
+		frame[6] = frame[2] ^ frame[3] ^ frame[4] ^ frame[5]; // BCC
+
+		status = mfrc522_select(frame, &sak);
+
+		if (status != STATUS_OK) {
+			return status;
+		}
+	}
+
+	return STATUS_OK;
+}
+
+
+uint8_t mfrc522_authenticate(uint8_t cmd, uint8_t block, const uint8_t *key, const UID_t *uid) {
+	uint8_t buffer[12];
+
+	buffer[0] = cmd;
+	buffer[1] = block;
+
+	for (uint8_t i = 0; i < 6; i++) {
+		buffer[2+i] = key[i];
+	}
+
+	// The last 4 bytes of UID are used for 7-byte and 10-byte UIDs.
+	for (uint8_t i = 0; i < 4; i++) {
+		buffer[8+i] = uid->UID[uid->size - 4 + i];
+	}
+
+	uint8_t status = mfrc522_command(MFRC522_CMD_AUTHENT, BIT_4, buffer, sizeof(buffer), 0, NULL, 0, false);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	// MFCrypto1On is set only if authentication has succeeded.
+	if (!(mfrc522_read(Status2Reg) & BIT_3)) {
+		return STATUS_ERROR;
+	}
+
+	return STATUS_OK;
+}
+
+
+void mfrc522_stopCrypto() {
+	mfrc522_setRegister(Status2Reg, BIT_3, 0);
+}
+
+
+uint8_t mfrc522_readBlock(uint8_t block, void *buffer) {
+	uint8_t txBuffer[4];
+	RFIDFrame_t rx = {buffer, 16}; // 16 bytes read in place, CRC_A apart
+
+	txBuffer[0] = MIFARE_CMD_READ;
+	txBuffer[1] = block;
+
+	uint8_t status = mfrc522_computeAndCheckCRC(txBuffer, 2, txBuffer+2, NULL);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	uint8_t count = 0;
+
+	attempt = 0;
+
+	do {
+		status = mfrc522_transceiveFrame(txBuffer, sizeof(txBuffer), &rx, true);
+
+		if (status == STATUS_OK && rx.size != 16) {
+			status = STATUS_ERROR;
+		}
+	} while (status != STATUS_OK && mfrc522_retryFrame(RETRY_READ, &count, status));
+
+	mfrc522_retryEnd(status);
+
+	return status;
+}
+
+
+uint8_t mfrc522_writeBlock(uint8_t block, const void *buffer) {
+	uint8_t txBuffer[18];
+
+	// Part 1: WRITE command and block address
+	txBuffer[0] = MIFARE_CMD_WRITE;
+	txBuffer[1] = block;
+
+	uint8_t status = mfrc522_computeAndCheckCRC(txBuffer, 2, txBuffer+2, NULL);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	status = mfrc522_transceiveAck(txBuffer, 4);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	// Part 2: 16-byte data
+	for (uint8_t i = 0; i < 16; i++) {
+		txBuffer[i] = ((const uint8_t*)buffer)[i];
+	}
+
+	status = mfrc522_computeAndCheckCRC(txBuffer, 16, txBuffer+16, NULL);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	return mfrc522_transceiveAck(txBuffer, sizeof(txBuffer));
+}
+
+
+uint8_t mfrc522_transceiveAck(const void *txBuffer, uint8_t txSize) {
+	uint8_t ack;
+	RFIDFrame_t rx = {&ack, 1};
+
+	uint8_t status = mfrc522_transceiveFrame(txBuffer, txSize, &rx, false);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	// ACK/NAK is a 4-bit frame.
+	if (rx.size != 1 || rx.lastBits != 4) {
+		return STATUS_ERROR;
+	}
+
+	if ((ack & 0x0F) != 0x0A) {
+		return STATUS_MIFARE_NACK;
+	}
+
+	return STATUS_OK;
+}
+
+
+uint8_t mfrc522_computeAndCheckCRC(const void *buffer, 
+									uint8_t size, 
+									void *crc,
+									bool *result) {
+
+	// CRC coprocessor needs the oscillator too
+	if (asleep) {
+		uint8_t status = mfrc522_wakeUp();
+
+		if (status != STATUS_OK) {
+			return status;
+		}
+	}
+
+	TRACE(TRACE_BEGIN | MFRC522_CMD_CALCCRC, size);
+	STATS_BEGIN();
+
+	uint8_t status = mfrc522_calculateCRC(buffer, size, crc, result);
+
+	STATS_END(MFRC522_CMD_CALCCRC, buffer, size, status);
+	TRACE(TRACE_END | MFRC522_CMD_CALCCRC, status);
+
+	return status;
+}
+
+
+uint8_t mfrc522_calculateCRC(const void *__buffer, 
+							uint8_t size, 
+							void *__crc,
+							bool *result) {
+	uint8_t *buffer = (uint8_t*)__buffer;
+	uint8_t *crc = (uint8_t*)__crc;
+
+	mfrc522_write(CommandReg, MFRC522_CMD_IDLE); // cancel current command
+	mfrc522_write(DivIrqReg, 0x04); // clear the CRC interrupt bit
+	mfrc522_setRegister(FIFOLevelReg, BIT_7, BIT_7); // immediately clear the internal FIFO 
+	mfrc522_writeFIFO(buffer, size); // Write data to FIFO
+	mfrc522_write(CommandReg, MFRC522_CMD_CALCCRC); // execute command calc CRC
+
+	// waiting for computing CRC
+	if (mfrc522_waitIRq(DivIrqReg, BIT_2, CRC_DEADLINE_US) == 0) {
+		return STATUS_HUNG;
+	}
+
+	// stop computing CRC
+	mfrc522_write(CommandReg, MFRC522_CMD_IDLE);
+
+	// get CRC value
+	crc[0] = mfrc522_read(CRCResultRegLSB);
+	crc[1] = mfrc522_read(CRCResultRegMSB);
+
+	// verify CRC
+	if (result != NULL) {
+		if ((buffer[size] == crc[0]) && buffer[size+1] == crc[1]) {
+			*result = true;
+		}
+		else {
+			*result = false;
+		}
+	}
+
+	return STATUS_OK;
+}
+
+
+uint16_t mfrc522_crcA(uint16_t crc, const uint8_t *data, uint8_t size) {
+	// ISO 14443-3 annex B, LSB first
+	while (size--) {
+		uint8_t ch = *data++ ^ (uint8_t)crc;
+
+		ch ^= ch << 4;
+		crc = (crc >> 8) ^ ((uint16_t)ch << 8) ^ ((uint16_t)ch << 3) ^ (ch >> 4);
+	}
+
+	return crc;
+}
+
+/**************************** Helper functions *******************************/
+
+void mfrc522_write(uint8_t reg, uint8_t data) {
+	// MSB = 0 is Write;
+	// Bit 6-1 is Address;
+	// LSB always = 0.
+	// See chapter 8.1.2.3 for detail infomation
+	// about write operation.
+	ACTIVATE();
+	TRANSFER((reg << 1) & 0x7E);
+	TRANSFER(data);
+	DEACTIVATE();
+
+	TRACE(TRACE_WRITE | reg, data);
+}
+
+
+uint8_t mfrc522_read(uint8_t reg) {
+	// MSB = 1 is Read;
+	// Bit 6-1 is Address;
+	// LSB always = 0.
+	// See chapter 8.1.2.3 for detail infomation
+	// about read operation.
+	ACTIVATE();
+	TRANSFER(((reg << 1) & 0x7E) | 0x80);
+	uint8_t data = TRANSFER(0x00); // 0x00 to STOP receiving.
+	DEACTIVATE();
+
+	TRACE(TRACE_READ | reg, data);
+
+	return data;
+}
+
+
+void mfrc522_writeFIFO(const void *buffer, uint16_t size) {
+	// MSB = 0 is Write;
+	// Bit 6-1 is Address;
+	// LSB always = 0.
+	// See chapter 8.1.2.2 for detail infomation
+	// about write operation.
+	ACTIVATE();
+	TRANSFER((FIFODataReg << 1) & 0x7E);
+
+	for (uint16_t i = 0; i < size; i++) {
+		TRANSFER(((const uint8_t*)buffer)[i]);
+	}
+
+	DEACTIVATE();
+
+#ifdef MFRC522_TRACE
+	for (uint16_t i = 0; i < size; i++) {
+		TRACE(TRACE_WRITE | FIFODataReg, ((const uint8_t*)buffer)[i]);
+	}
+#endif
+}
+
+
+void mfrc522_readFIFO(void *__buffer, uint16_t size, void *__tail, uint8_t tailSize) {
+	// MSB = 1 is Read;
+	// Bit 6-1 is Address;
+	// LSB always = 0.
+	// See chapter 8.1.2.1 for detail infomation
+	// about read operation.
+
+	uint8_t *buffer = (uint8_t*)__buffer;
+	uint8_t *tail = (uint8_t*)__tail;
+	uint8_t address = ((FIFODataReg << 1) & 0x7E) | 0x80;
+	uint16_t total = size + tailSize;
+
+	if (total == 0) {
+		return;
+	}
+
+	// One transfer for both slices: buffer, then tail
+	ACTIVATE();
+	TRANSFER(address);
+
+	for (uint16_t i = 0; i < total; i++) {
+		// Last byte is receive with 0x00 to STOP receiving.
+		uint8_t data = TRANSFER(i < total-1 ? address : 0x00);
+
+		if (i < size) {
+			buffer[i] = data;
+		}
+		else {
+			tail[i - size] = data;
+		}
+	}
+
+	DEACTIVATE();
+
+#ifdef MFRC522_TRACE
+	for (uint16_t i = 0; i < total; i++) {
+		TRACE(TRACE_READ | FIFODataReg, i < size ? buffer[i] : tail[i - size]);
+	}
+#endif
+}
+
+
+void mfrc522_setTimeout(uint16_t reload) {
+	mfrc522_write(TReloadRegH, reload >> 8);
+	mfrc522_write(TReloadRegL, reload & 0xFF);
+	timeout = reload;
+}
+
+
+uint8_t mfrc522_waitIRq(uint8_t reg, uint8_t mask, uint32_t deadline) {
+	uint32_t waited = 0;
+	uint16_t busy = BUSY_POLLS;
+
+	while (1) {
+		uint8_t irq = mfrc522_read(reg);
+
+		if (irq & mask) {
+			rung = RECOVER_CANCEL;
+			return irq;
+		}
+
+		if (busy) {
+			busy--;
+		}
+		else if (waited >= deadline) {
+			recovery.hangs++;
+			mfrc522_recover();
+			return 0;
+		}
+		else {
+			mfrc522_port_delayUs(POLL_INTERVAL_US);
+			waited += POLL_INTERVAL_US;
+		}
+
+		STATS_POLL();
+	}
+}
+
+
+bool mfrc522_healthy() {
+	// Timer ends every wait, its registers are back to reset values
+	// after a brown-out of the reader.
+	return mfrc522_checkVersion()
+			&& !(mfrc522_read(CommandReg) & BIT_4)
+			&& mfrc522_read(TModeReg) == pgm_read_byte(&PROFILES[profile][0])
+			&& mfrc522_read(TPrescalerReg) == pgm_read_byte(&PROFILES[profile][1]);
+}
+
+
+void mfrc522_configure() {
+	RFIDProfile_t kept = profile;
+
+	// All registers of current profile are written again
+	profile = PROFILE_RESET;
+	mfrc522_setProfile(kept);
+	timeout = DEFAULT_TIMEOUT;
+	asleep = false;
+}
+
+
+void mfrc522_fieldReset() {
+	uint8_t txControl = pgm_read_byte(&PROFILES[profile][PROFILE_TXCONTROL]);
+
+	mfrc522_write(TxControlReg, txControl & ~0x03);
+	mfrc522_port_delayUs(RF_RESET_US);
+	mfrc522_write(TxControlReg, txControl);
+}
+
+
+void mfrc522_applyTuning(const RFTuning_t *values) {
+	mfrc522_write(RFCfgReg, values->rxGain);
+	mfrc522_write(RxThresholdReg, values->rxThreshold);
+	mfrc522_write(DemodReg, values->demod);
+	mfrc522_write(CWGsPReg, values->cwGsP);
+	mfrc522_write(ModGsPReg, values->modGsP);
+	mfrc522_write(GsNReg, values->gsN);
+}
+
+
+bool mfrc522_loopback() {
+	uint8_t chunk[LOOPBACK_CHUNK];
+
+	for (uint8_t round = 0; round < LOOPBACK_ROUNDS; round++) {
+		uint32_t start = pattern;
+
+		if (!mfrc522_checkVersion()) {
+			return false;
+		}
+
+		mfrc522_setRegister(FIFOLevelReg, BIT_7, BIT_7); // immediately clear the internal FIFO
+
+		for (uint8_t i = 0; i < FIFO_SIZE; i += LOOPBACK_CHUNK) {
+			for (uint8_t j = 0; j < LOOPBACK_CHUNK; j++) {
+				chunk[j] = mfrc522_pattern();
+			}
+
+			mfrc522_writeFIFO(chunk, LOOPBACK_CHUNK);
+		}
+
+		if (mfrc522_read(FIFOLevelReg) != FIFO_SIZE) {
+			return false;
+		}
+
+		// Same patterns again to check what is read back
+		pattern = start;
+
+		for (uint8_t i = 0; i < FIFO_SIZE; i += LOOPBACK_CHUNK) {
+			mfrc522_readFIFO(chunk, LOOPBACK_CHUNK, NULL, 0);
+
+			for (uint8_t j = 0; j < LOOPBACK_CHUNK; j++) {
+				if (chunk[j] != mfrc522_pattern()) {
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+
+uint8_t mfrc522_pattern() {
+	pattern ^= pattern << 13;
+	pattern ^= pattern >> 17;
+	pattern ^= pattern << 5;
+
+	return pattern;
+}
+
+
+uint8_t mfrc522_digitalTest(uint8_t version) {
+	uint8_t chunk[LOOPBACK_CHUNK] = {0};
+
+	// Clear the internal buffer: 25 zero bytes stored by Mem command
+	mfrc522_setRegister(FIFOLevelReg, BIT_7, BIT_7);
+	mfrc522_writeFIFO(chunk, LOOPBACK_CHUNK);
+	mfrc522_writeFIFO(chunk, SELFTEST_BUFFER - LOOPBACK_CHUNK);
+	mfrc522_write(CommandReg, MFRC522_CMD_MEM);
+
+	// Self-test mode, started by CalcCRC over a single zero byte
+	mfrc522_write(AutoTestReg, AUTOTEST_SELFTEST);
+	mfrc522_writeFIFO(chunk, 1);
+	mfrc522_write(CommandReg, MFRC522_CMD_CALCCRC);
+
+	uint32_t waited = 0;
+
+	while (mfrc522_read(FIFOLevelReg) < FIFO_SIZE) {
+		if (waited >= SELFTEST_DEADLINE_US) {
+			return STATUS_TIMEOUT;
+		}
+
+		mfrc522_port_delayUs(POLL_INTERVAL_US);
+		waited += POLL_INTERVAL_US;
+	}
+
+	uint8_t index = 0;
+
+	while (index < sizeof(SELFTEST_VERSIONS) && pgm_read_byte(&SELFTEST_VERSIONS[index]) != version) {
+		index++;
+	}
+
+	if (index == sizeof(SELFTEST_VERSIONS)) {
+		return STATUS_INVALID;
+	}
+
+	for (uint8_t i = 0; i < FIFO_SIZE; i += LOOPBACK_CHUNK) {
+		mfrc522_readFIFO(chunk, LOOPBACK_CHUNK, NULL, 0);
+
+		for (uint8_t j = 0; j < LOOPBACK_CHUNK; j++) {
+			if (chunk[j] != pgm_read_byte(&SELFTEST_REFERENCES[index][i + j])) {
+				return STATUS_ERROR;
+			}
+		}
+	}
+
+	return STATUS_OK;
+}
+
+
+bool mfrc522_retryable(uint8_t status) {
+	return status == STATUS_ERROR || status == STATUS_COLLISION
+			|| status == STATUS_CRC_WRONG || status == STATUS_TIMEOUT;
+}
+
+
+bool mfrc522_retryFrame(RetryStep_t step, uint8_t *count, uint8_t status) {
+	if (!mfrc522_retryCount(step, count, status)) {
+		return false;
+	}
+
+	mfrc522_backoff();
+
+	return true;
+}
+
+
+bool mfrc522_retryCount(RetryStep_t step, uint8_t *count, uint8_t status) {
+	// A silent card went back to IDLE, only a restart can reach it
+	if (status == STATUS_TIMEOUT || !mfrc522_retryable(status) || *count >= policy.frames[step]) {
+		return false;
+	}
+
+	(*count)++;
+	retries.frames++;
+
+	return true;
+}
+
+
+void mfrc522_backoff() {
+	uint16_t delay = mfrc522_backoffDelay();
+
+	if (delay) {
+		mfrc522_port_delayUs(delay);
+	}
+}
+
+
+uint16_t mfrc522_backoffDelay() {
+	uint32_t delay = (uint32_t)policy.backoff << (attempt < 8 ? attempt : 8);
+
+	attempt++;
+
+	return delay > 0xFFFF ? 0xFFFF : delay;
+}
+
+
+void mfrc522_retryEnd(uint8_t status) {
+	if (attempt == 0) {
+		return;
+	}
+
+	if (status == STATUS_OK) {
+		retries.recovered++;
+	}
+	else {
+		retries.failed++;
+	}
+}
+
+
+void mfrc522_setRegister(uint8_t reg, uint8_t bits, uint8_t value) {
+	uint8_t data = mfrc522_read(reg);
+
+	data = (data & ~bits) | value;
+	mfrc522_write(reg, data);
+}
+
+
+#ifndef MFRC522_SS_PORT
+
+void mfrc522_saveReader(RFIDReader_t *reader) {
+	reader->profile = profile;
+	reader->tuning = tuning;
+	reader->tuned = tuned;
+	reader->asleep = asleep;
+	reader->guard = guard;
+	reader->window = window;
+	reader->timeout = timeout;
+	reader->rung = rung;
+	reader->recovery = recovery;
+	reader->policy = policy;
+	reader->retries = retries;
+	reader->health = health;
+	reader->tracked = tracked;
+	reader->tracking = tracking;
+}
+
+
+void mfrc522_loadReader(const RFIDReader_t *reader) {
+	profile = reader->profile;
+	tuning = reader->tuning;
+	tuned = reader->tuned;
+	asleep = reader->asleep;
+	guard = reader->guard;
+	window = reader->window;
+	timeout = reader->timeout;
+	rung = reader->rung;
+	recovery = reader->recovery;
+	policy = reader->policy;
+	retries = reader->retries;
+	health = reader->health;
+	tracked = reader->tracked;
+	tracking = reader->tracking;
+}
+
+
+void mfrc522_overlapStart(Overlap_t *overlap, uint8_t i, uint8_t command,
+							const void *txBuffer, uint8_t txSize, uint8_t bitFraming) {
+	TRACE(TRACE_BEGIN | command, txSize);
+	mfrc522_start(command, txBuffer, txSize, bitFraming);
+
+	overlap->pending |= 1 << i;
+	overlap->started[i] = overlap->waited;
+	overlap->busy = BUSY_POLLS;
+	STATS_OVERLAP_START(overlap, i);
+}
+
+
+uint8_t mfrc522_overlapNext(Overlap_t *overlap, uint8_t *irq) {
+	// Readers are polled in turn, binding the platform layer only: the state
+	// of a reader is swapped in once its command ended, with the deadline of
+	// mfrc522_waitIRq() from its own timeout.
+	while (1) {
+		uint8_t i = overlap->turn++;
+
+		if (i == overlap->count) {
+			overlap->turn = 0;
+
+			// Paced as mfrc522_waitIRq(), unless a command ended this round
+			if (!overlap->ended) {
+				if (overlap->busy) {
+					overlap->busy--;
+				}
+				else {
+					mfrc522_port_delayUs(POLL_INTERVAL_US);
+					overlap->waited += POLL_INTERVAL_US;
+				}
+
+				STATS_POLL();
+			}
+
+			overlap->ended = false;
+
+			// Deferred readers are started by the caller
+			if (overlap->deferred) {
+				return OVERLAP_ROUND;
+			}
+
+			continue;
+		}
+
+		if (!(overlap->pending & (1 << i))) {
+			continue;
+		}
+
+		RFIDReader_t *reader = &overlap->readers[i];
+
+		mfrc522_port_bind(reader->port);
+		*irq = mfrc522_read(ComIrqReg);
+
+		if (*irq & 0x31) {
+			mfrc522_useReader(reader);
+			rung = RECOVER_CANCEL;
+		}
+		else if (!overlap->busy && overlap->waited - overlap->started[i]
+					>= (uint32_t)reader->timeout * TIMER_TICK_US + FRAME_MARGIN_US) {
+			mfrc522_useReader(reader);
+			recovery.hangs++;
+			mfrc522_recover();
+			*irq = 0;
+		}
+		else {
+			continue;
+		}
+
+		overlap->pending &= ~(1 << i);
+		overlap->ended = true;
+
+		return i;
+	}
+}
+
+
+void mfrc522_overlapEnd(Overlap_t *overlap, uint8_t i, uint8_t command,
+						const void *txBuffer, uint8_t txSize, uint8_t status) {
+	STATS_OVERLAP_END(overlap, i, command, txBuffer, txSize, status);
+	TRACE(TRACE_END | command, status);
+}
+
+
+void mfrc522_selectingBegin(Selecting_t *selecting, uint8_t level) {
+	selecting->frame[0] = CASCADE_SEL[level];
+	selecting->level = level;
+	selecting->knownBits = 0;
+	selecting->loops = 32;
+	selecting->count = 0;
+	selecting->select = false;
+}
+
+
+void mfrc522_selectingStart(Overlap_t *overlap, uint8_t i, Selecting_t *selecting) {
+	uint8_t *frame = selecting->frame;
+
+	if (selecting->select) {
+		frame[1] = 0x70; // NVB (Number of Valid Bits)
+
+		// CRC_A in software, the CRC coprocessor would wait alone
+		uint16_t crc = mfrc522_crcA(CRC_A_PRESET, frame, 7);
+
+		frame[7] = crc;
+		frame[8] = crc >> 8;
+
+		mfrc522_overlapStart(overlap, i, MFRC522_CMD_TRANSCEIVE, frame, 9, 0);
+		return;
+	}
+
+	uint8_t bytes = selecting->knownBits / 8;
+	uint8_t bits = selecting->knownBits % 8;
+
+	selecting->known = frame[2+bytes] & ((1 << bits) - 1);
+	selecting->loops--;
+
+	mfrc522_overlapStart(overlap, i, MFRC522_CMD_TRANSCEIVE, frame,
+						mfrc522_anticollisionFrame(frame, selecting->knownBits),
+						(bits << 4) | bits);
+}
+
+
+uint8_t mfrc522_selectingEnd(Overlap_t *overlap, uint8_t i, Selecting_t *selecting,
+								UID_t *uid, uint8_t irq) {
+	uint8_t *frame = selecting->frame;
+	uint8_t status;
+
+	if (!selecting->select) {
+		uint8_t bytes = selecting->knownBits / 8;
+		uint8_t size = 2 + bytes + (selecting->knownBits % 8 ? 1 : 0);
+		RFIDFrame_t rx = {frame + 2 + bytes, 7 - bytes};
+
+		status = mfrc522_finish(irq, 0x30, &rx, false);
+		mfrc522_overlapEnd(overlap, i, MFRC522_CMD_TRANSCEIVE, frame, size, status);
+
+		// As mfrc522_anticollision()
+		status = mfrc522_anticollisionAnswer(frame, &selecting->knownBits, selecting->known,
+											status, rx.size);
+
+		if (status == STATUS_OK) {
+			selecting->select = true;
+			selecting->count = 0;
+			return NEXT_FRAME;
+		}
+
+		if (status != NEXT_FRAME && status != STATUS_COLLISION
+			&& mfrc522_retryLater(overlap, RETRY_ANTICOLLISION, selecting, status)) {
+			status = NEXT_FRAME;
+		}
+
+		if (status == NEXT_FRAME && selecting->loops == 0) {
+			return STATUS_COLLISION;
+		}
+
+		return status;
+	}
+
+	RFIDFrame_t rx = {&uid->SAK, 1};
+
+	status = mfrc522_finish(irq, 0x30, &rx, true);
+	mfrc522_overlapEnd(overlap, i, MFRC522_CMD_TRANSCEIVE, frame, 9, status);
+
+	// As mfrc522_select() and mfrc522_readID()
+	if (status != STATUS_OK) {
+		return mfrc522_retryLater(overlap, RETRY_SELECT, selecting, status) ? NEXT_FRAME : status;
+	}
+
+	// Every cascade level but the last one starts with Cascade Tag.
+	bool cascade = uid->SAK & BIT_2;
+
+	for (uint8_t j = cascade ? 1 : 0; j < 4; j++) {
+		uid->UID[uid->size++] = frame[2+j];
+	}
+
+	if (!cascade) {
+		return STATUS_OK;
+	}
+
+	if (selecting->level == 2) {
+		return STATUS_INTERNAL_ERROR;
+	}
+
+	mfrc522_selectingBegin(selecting, selecting->level + 1);
+
+	return NEXT_FRAME;
+}
+
+
+bool mfrc522_retryLater(Overlap_t *overlap, RetryStep_t step, Selecting_t *selecting,
+						uint8_t status) {
+	// As mfrc522_retryFrame(), the back-off is a deadline instead of a delay:
+	// the other readers keep polling meanwhile.
+	if (!mfrc522_retryCount(step, &selecting->count, status)) {
+		return false;
+	}
+
+	selecting->notBefore = overlap->waited + mfrc522_backoffDelay();
+
+	return true;
+}
+
+#endif
+
+/**************************** End of File ************************************/
\ No newline at end of file
@@ -0,0 +1,173 @@
+
+//! \file mfrc522_allowlist.c
+//! \brief Read-only UID index of enrolled cards, placed in flash.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_allowlist.h"
+
+#ifdef __AVR__
+#define FLASH_BYTE(address)	pgm_read_byte(address)
+#else
+#define FLASH_BYTE(address)	(*(const uint8_t*)(address))
+#endif
+
+// Header fields
+#define OFFSET_VERSION	4
+#define OFFSET_COUNT	6
+#define OFFSET_CRC		12
+
+
+// Table sizes, in the order of the blob
+static const uint8_t SIZES[3] = {4, 7, 10};
+
+static uint16_t allowlist_word(const uint8_t *address);
+static uint32_t allowlist_prefix(const uint8_t *entry);
+static int8_t allowlist_compare(const uint8_t *entry, const uint8_t *uid, uint8_t size);
+
+
+bool mfrc522_allowlistCheck(const uint8_t *blob) {
+	if (FLASH_BYTE(blob) != 'U' || FLASH_BYTE(blob + 1) != 'I'
+		|| FLASH_BYTE(blob + 2) != 'D' || FLASH_BYTE(blob + 3) != 'X'
+		|| FLASH_BYTE(blob + OFFSET_VERSION) != ALLOWLIST_VERSION) {
+
+		return false;
+	}
+
+	// Each card takes its UID and a 2-byte record number
+	uint32_t size = 0;
+
+	for (uint8_t i = 0; i < 3; i++) {
+		size += (uint32_t)allowlist_word(blob + OFFSET_COUNT + 2*i) * (SIZES[i] + 2);
+	}
+
+	// CRC-16/CCITT, polynomial 0x1021, preset 0xFFFF
+	uint16_t crc = 0xFFFF;
+
+	for (uint32_t i = 0; i < size; i++) {
+		crc ^= (uint16_t)FLASH_BYTE(blob + ALLOWLIST_HEADER + i) << 8;
+
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+
+	return crc == allowlist_word(blob + OFFSET_CRC);
+}
+
+
+uint16_t mfrc522_allowlistCount(const uint8_t *blob) {
+	return allowlist_word(blob + OFFSET_COUNT)
+			+ allowlist_word(blob + OFFSET_COUNT + 2)
+			+ allowlist_word(blob + OFFSET_COUNT + 4);
+}
+
+
+uint16_t mfrc522_allowlistLookup(const uint8_t *blob, const UID_t *uid) {
+	const uint8_t *table = blob + ALLOWLIST_HEADER;
+	uint16_t before = 0; // cards in the tables before this one
+	uint16_t count = 0;
+	uint8_t size = uid->size;
+	uint8_t i;
+
+	for (i = 0; i < 3; i++) {
+		count = allowlist_word(blob + OFFSET_COUNT + 2*i);
+
+		if (SIZES[i] == size) {
+			break;
+		}
+
+		table += (uint32_t)count * SIZES[i];
+		before += count;
+	}
+
+	if (i == 3 || count == 0) {
+		return ALLOWLIST_NOT_FOUND;
+	}
+
+	const uint8_t *records = blob + ALLOWLIST_HEADER;
+
+	for (i = 0; i < 3; i++) {
+		records += (uint32_t)allowlist_word(blob + OFFSET_COUNT + 2*i) * SIZES[i];
+	}
+
+	// UIDs are sorted bytewise, so their 4-byte prefixes are sorted too
+	const uint8_t *id = uid->UID;
+	uint32_t key = ((uint32_t)id[0] << 24) | ((uint32_t)id[1] << 16) | ((uint32_t)id[2] << 8) | id[3];
+	uint16_t low = 0;
+	uint16_t high = count - 1;
+	bool interpolate = true;
+
+	while (low <= high) {
+		uint32_t lowKey = allowlist_prefix(table + (uint32_t)low * size);
+		uint32_t highKey = allowlist_prefix(table + (uint32_t)high * size);
+
+		if (key < lowKey || key > highKey) {
+			return ALLOWLIST_NOT_FOUND;
+		}
+
+		uint16_t middle = low + (high - low) / 2;
+
+		// Every other step bisects, bounding the probes to 2*log2(n)
+		if (interpolate && highKey > lowKey) {
+			uint32_t range = highKey - lowKey;
+			uint32_t offset = key - lowKey;
+
+			// 16-bit fraction keeps the product in 32 bits
+			while (range > 0xFFFF) {
+				range >>= 1;
+				offset >>= 1;
+			}
+
+			middle = low + offset * (high - low) / range;
+		}
+
+		interpolate = !interpolate;
+
+		int8_t result = allowlist_compare(table + (uint32_t)middle * size, id, size);
+
+		if (result == 0) {
+			return allowlist_word(records + 2 * (uint32_t)(before + middle));
+		}
+
+		if (result < 0) {
+			low = middle + 1;
+		}
+		else if (middle == 0) {
+			break;
+		}
+		else {
+			high = middle - 1;
+		}
+	}
+
+	return ALLOWLIST_NOT_FOUND;
+}
+
+/**************************** Helper functions *******************************/
+
+uint16_t allowlist_word(const uint8_t *address) {
+	return FLASH_BYTE(address) | ((uint16_t)FLASH_BYTE(address + 1) << 8);
+}
+
+
+uint32_t allowlist_prefix(const uint8_t *entry) {
+	return ((uint32_t)FLASH_BYTE(entry) << 24) | ((uint32_t)FLASH_BYTE(entry + 1) << 16)
+			| ((uint32_t)FLASH_BYTE(entry + 2) << 8) | FLASH_BYTE(entry + 3);
+}
+
+
+int8_t allowlist_compare(const uint8_t *entry, const uint8_t *uid, uint8_t size) {
+	for (uint8_t i = 0; i < size; i++) {
+		uint8_t byte = FLASH_BYTE(entry + i);
+
+		if (byte != uid[i]) {
+			return (byte < uid[i]) ? -1 : 1;
+		}
+	}
+
+	return 0;
+}
+
+/**************************** End of File ************************************/
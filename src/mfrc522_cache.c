@@ -0,0 +1,301 @@
+
+//! \file mfrc522_cache.c
+//! \brief UID-keyed cache of MIFARE card blocks
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_cache.h"
+#include "mfrc522_status.h"
+
+#include <string.h>
+
+
+#define NO_CARD		0xFF
+
+
+typedef struct CacheCard {
+	UID_t uid;
+	uint8_t version[16]; // last seen content of version block
+	uint32_t loaded; // tick when version block was read
+	uint16_t stamp; // LRU stamp
+	bool used;
+} CacheCard_t;
+
+
+typedef struct CacheBlock {
+	uint8_t data[16];
+	uint8_t card; // index in cards[], NO_CARD if free
+	uint8_t block;
+	uint16_t stamp; // LRU stamp
+} CacheBlock_t;
+
+
+static CacheCard_t cards[MFRC522_CACHE_CARDS];
+static CacheBlock_t blocks[MFRC522_CACHE_BLOCKS];
+static CacheStats_t stats;
+
+static uint8_t versionBlock;
+static uint32_t ttl;
+static uint32_t (*now)(void);
+static uint16_t lruClock;
+
+static uint8_t cache_findCard(const UID_t *uid);
+static uint8_t cache_addCard(const UID_t *uid);
+static CacheBlock_t* cache_findBlock(uint8_t card, uint8_t block);
+static void cache_store(uint8_t card, uint8_t block, const void *buffer);
+static void cache_dropCard(uint8_t card);
+
+
+void mfrc522_cacheInit(uint8_t __versionBlock, uint32_t __ttl, uint32_t (*__now)(void)) {
+	versionBlock = __versionBlock;
+	ttl = __ttl;
+	now = __now;
+	lruClock = 0;
+
+	for (uint8_t i = 0; i < MFRC522_CACHE_CARDS; i++) {
+		cards[i].used = false;
+	}
+
+	for (uint8_t i = 0; i < MFRC522_CACHE_BLOCKS; i++) {
+		blocks[i].card = NO_CARD;
+	}
+
+	mfrc522_cacheResetStats();
+}
+
+
+uint8_t mfrc522_cacheOpen(const UID_t *uid) {
+	uint8_t version[16];
+	uint8_t status = mfrc522_readBlock(versionBlock, version);
+
+	stats.validations++;
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	uint8_t card = cache_findCard(uid);
+
+	if (card != NO_CARD) {
+		bool expired = (ttl && now && (now() - cards[card].loaded) > ttl);
+
+		if (!expired && memcmp(cards[card].version, version, 16) == 0) {
+			cards[card].stamp = ++lruClock;
+			return STATUS_OK;
+		}
+
+		cache_dropCard(card);
+		stats.invalidations++;
+	}
+
+	card = cache_addCard(uid);
+	memcpy(cards[card].version, version, 16);
+	cards[card].loaded = now ? now() : 0;
+
+	// version block is just read, keep it too.
+	cache_store(card, versionBlock, version);
+
+	return STATUS_OK;
+}
+
+
+bool mfrc522_cacheLookup(const UID_t *uid, uint8_t block, void *buffer) {
+	uint8_t card = cache_findCard(uid);
+
+	if (card == NO_CARD) {
+		return false;
+	}
+
+	CacheBlock_t *entry = cache_findBlock(card, block);
+
+	if (entry == NULL) {
+		return false;
+	}
+
+	memcpy(buffer, entry->data, 16);
+	entry->stamp = ++lruClock;
+
+	return true;
+}
+
+
+uint8_t mfrc522_cacheRead(const UID_t *uid, uint8_t block, void *buffer) {
+	if (mfrc522_cacheLookup(uid, block, buffer)) {
+		stats.hits++;
+		return STATUS_OK;
+	}
+
+	stats.misses++;
+
+	uint8_t status = mfrc522_readBlock(block, buffer);
+
+	if (status != STATUS_OK) {
+		return status;
+	}
+
+	// Only cards validated by mfrc522_cacheOpen() are cached.
+	uint8_t card = cache_findCard(uid);
+
+	if (card != NO_CARD) {
+		cache_store(card, block, buffer);
+	}
+
+	return STATUS_OK;
+}
+
+
+uint8_t mfrc522_cacheWrite(const UID_t *uid, uint8_t block, const void *buffer) {
+	uint8_t status = mfrc522_writeBlock(block, buffer);
+	uint8_t card = cache_findCard(uid);
+
+	if (card == NO_CARD) {
+		return status;
+	}
+
+	if (status != STATUS_OK) {
+		// Card content is unknown now.
+		cache_dropCard(card);
+		return status;
+	}
+
+	if (uid->SAK & 0x08) {
+		// MIFARE Classic: the whole block is written.
+		cache_store(card, block, buffer);
+
+		if (block == versionBlock) {
+			memcpy(cards[card].version, buffer, 16);
+		}
+	}
+	else {
+		// MIFARE Ultralight: only one page is written,
+		// it is part of any 4-page read starting at block-3..block.
+		for (uint8_t i = 0; i < MFRC522_CACHE_BLOCKS; i++) {
+			if (blocks[i].card == card && (uint8_t)(block - blocks[i].block) < 4) {
+				blocks[i].card = NO_CARD;
+			}
+		}
+
+		if ((uint8_t)(block - versionBlock) < 4) {
+			cache_dropCard(card);
+		}
+	}
+
+	return STATUS_OK;
+}
+
+
+void mfrc522_cacheInvalidate(const UID_t *uid) {
+	uint8_t card = cache_findCard(uid);
+
+	if (card != NO_CARD) {
+		cache_dropCard(card);
+	}
+}
+
+
+void mfrc522_cacheGetStats(CacheStats_t *__stats) {
+	*__stats = stats;
+}
+
+
+void mfrc522_cacheResetStats() {
+	memset(&stats, 0, sizeof(stats));
+}
+
+/**************************** Helper functions *******************************/
+
+uint8_t cache_findCard(const UID_t *uid) {
+	for (uint8_t i = 0; i < MFRC522_CACHE_CARDS; i++) {
+		if (cards[i].used
+			&& cards[i].uid.size == uid->size
+			&& memcmp(cards[i].uid.UID, uid->UID, uid->size) == 0) {
+
+			return i;
+		}
+	}
+
+	return NO_CARD;
+}
+
+
+uint8_t cache_addCard(const UID_t *uid) {
+	uint8_t card = 0;
+
+	// Take a free slot, or the least recently used one.
+	for (uint8_t i = 0; i < MFRC522_CACHE_CARDS; i++) {
+		if (!cards[i].used) {
+			card = i;
+			break;
+		}
+
+		if ((uint16_t)(lruClock - cards[i].stamp) > (uint16_t)(lruClock - cards[card].stamp)) {
+			card = i;
+		}
+	}
+
+	if (cards[card].used) {
+		cache_dropCard(card);
+		stats.evictions++;
+	}
+
+	cards[card].uid = *uid;
+	cards[card].stamp = ++lruClock;
+	cards[card].used = true;
+
+	return card;
+}
+
+
+CacheBlock_t* cache_findBlock(uint8_t card, uint8_t block) {
+	for (uint8_t i = 0; i < MFRC522_CACHE_BLOCKS; i++) {
+		if (blocks[i].card == card && blocks[i].block == block) {
+			return &blocks[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+void cache_store(uint8_t card, uint8_t block, const void *buffer) {
+	CacheBlock_t *entry = cache_findBlock(card, block);
+
+	if (entry == NULL) {
+		entry = &blocks[0];
+
+		// Take a free entry, or the least recently used one.
+		for (uint8_t i = 0; i < MFRC522_CACHE_BLOCKS; i++) {
+			if (blocks[i].card == NO_CARD) {
+				entry = &blocks[i];
+				break;
+			}
+
+			if ((uint16_t)(lruClock - blocks[i].stamp) > (uint16_t)(lruClock - entry->stamp)) {
+				entry = &blocks[i];
+			}
+		}
+
+		if (entry->card != NO_CARD) {
+			stats.evictions++;
+		}
+	}
+
+	memcpy(entry->data, buffer, 16);
+	entry->card = card;
+	entry->block = block;
+	entry->stamp = ++lruClock;
+}
+
+
+void cache_dropCard(uint8_t card) {
+	for (uint8_t i = 0; i < MFRC522_CACHE_BLOCKS; i++) {
+		if (blocks[i].card == card) {
+			blocks[i].card = NO_CARD;
+		}
+	}
+
+	cards[card].used = false;
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,197 @@
+
+//! \file mfrc522_calibration.c
+//! \brief Calibration of the RF front-end against a reference card
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_calibration.h"
+#include "mfrc522_status.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#define PROGMEM
+#define pgm_read_byte(address)	(*(const uint8_t*)(address))
+#endif
+
+
+#define RXGAIN_MASK		0x70
+#define CWGSN_MASK		0xF0
+#define KNOB_VALUES		6
+
+
+typedef struct Score {
+	uint8_t successes;
+	uint32_t latency; // sum over successes
+} Score_t;
+
+
+// Candidates of one register field
+typedef struct Knob {
+	uint8_t offset; // of the register in RFTuning_t
+	uint8_t mask;
+	uint8_t count;
+	uint8_t values[KNOB_VALUES];
+} Knob_t;
+
+
+// Field strength, weaker first: CWGsPReg and CWGsN of GsNReg
+static const uint8_t DRIVES[][2] PROGMEM = {
+	{0x10, 0x40}, {0x20, 0x80}, {0x30, 0xC0}, {0x3F, 0xF0}
+};
+
+// RxGain of RFCfgReg, lower first: 18, 23, 33, 38, 43, 48 dB
+static const uint8_t GAINS[] PROGMEM = {0x00, 0x10, 0x40, 0x50, 0x60, 0x70};
+
+// Swept one by one once field and gain are set
+static const Knob_t KNOBS[] PROGMEM = {
+	// MinLevel of RxThresholdReg, less sensitive to noise first
+	{offsetof(RFTuning_t, rxThreshold), 0xF0, 6, {0xC0, 0xA0, 0x80, 0x60, 0x40, 0x20}},
+
+	// Conductance during modulation: ModGsPReg, then ModGsN of GsNReg
+	{offsetof(RFTuning_t, modGsP), 0x3F, 4, {0x08, 0x10, 0x20, 0x3F}},
+	{offsetof(RFTuning_t, gsN), 0x0F, 3, {0x04, 0x08, 0x0F}},
+
+	// AddIQ of DemodReg: stronger channel, stronger channel frozen, I and Q combined
+	{offsetof(RFTuning_t, demod), 0xC0, 3, {0x00, 0x40, 0x80}}
+};
+
+
+typedef struct Sweep {
+	const UID_t *card;
+	uint8_t trials;
+	uint32_t (*now)(void);
+	RFTuning_t best;
+	Score_t score;
+	uint8_t candidates;
+} Sweep_t;
+
+static void calibration_try(Sweep_t *sweep, const RFTuning_t *candidate);
+static Score_t calibration_score(const Sweep_t *sweep, const RFTuning_t *tuning);
+static bool calibration_better(const Sweep_t *sweep, const Score_t *score);
+static bool calibration_match(const UID_t *card, const UID_t *uid);
+
+
+bool mfrc522_calibrate(const UID_t *card, uint8_t trials, uint32_t (*now)(void),
+						CalibrationResult_t *result) {
+
+	Sweep_t sweep = {.card = card, .trials = trials, .now = now, .candidates = 1};
+	RFTuning_t start;
+	bool tuned = mfrc522_getTuning(&start);
+
+	sweep.best = start;
+	sweep.score = calibration_score(&sweep, &start);
+	result->before = sweep.score.successes;
+
+	for (uint8_t d = 0; d < sizeof(DRIVES) / sizeof(DRIVES[0]); d++) {
+		for (uint8_t g = 0; g < sizeof(GAINS); g++) {
+			RFTuning_t candidate = sweep.best;
+
+			candidate.cwGsP = pgm_read_byte(&DRIVES[d][0]);
+			candidate.gsN = (candidate.gsN & ~CWGSN_MASK) | pgm_read_byte(&DRIVES[d][1]);
+			candidate.rxGain = (candidate.rxGain & ~RXGAIN_MASK) | pgm_read_byte(&GAINS[g]);
+
+			calibration_try(&sweep, &candidate);
+		}
+	}
+
+	for (uint8_t k = 0; k < sizeof(KNOBS) / sizeof(KNOBS[0]); k++) {
+		uint8_t offset = pgm_read_byte(&KNOBS[k].offset);
+		uint8_t mask = pgm_read_byte(&KNOBS[k].mask);
+
+		for (uint8_t v = 0; v < pgm_read_byte(&KNOBS[k].count); v++) {
+			RFTuning_t candidate = sweep.best;
+			uint8_t *field = (uint8_t*)&candidate + offset;
+
+			*field = (*field & ~mask) | pgm_read_byte(&KNOBS[k].values[v]);
+			calibration_try(&sweep, &candidate);
+		}
+	}
+
+	result->candidates = sweep.candidates;
+	result->after = sweep.score.successes;
+
+	if (sweep.score.successes == 0) {
+		mfrc522_setTuning(tuned ? &start : NULL);
+		result->tuning = start;
+		result->latency = 0;
+		return false;
+	}
+
+	mfrc522_setTuning(&sweep.best);
+	result->tuning = sweep.best;
+	result->latency = sweep.score.latency / sweep.score.successes;
+
+	return true;
+}
+
+/**************************** Helper functions *******************************/
+
+void calibration_try(Sweep_t *sweep, const RFTuning_t *candidate) {
+	if (memcmp(candidate, &sweep->best, sizeof(RFTuning_t)) == 0) {
+		return;
+	}
+
+	Score_t score = calibration_score(sweep, candidate);
+
+	sweep->candidates++;
+
+	if (calibration_better(sweep, &score)) {
+		sweep->best = *candidate;
+		sweep->score = score;
+	}
+}
+
+
+Score_t calibration_score(const Sweep_t *sweep, const RFTuning_t *tuning) {
+	Score_t score = {0, 0};
+
+	mfrc522_setTuning(tuning);
+
+	for (uint8_t i = 0; i < sweep->trials; i++) {
+		UID_t uid;
+
+		// Field off and on: the card powers up from reset
+		mfrc522_powerDown();
+
+		if (mfrc522_wakeUp() != STATUS_OK) {
+			continue;
+		}
+
+		uint32_t start = sweep->now();
+
+		if (mfrc522_available() && mfrc522_getID(&uid) == STATUS_OK
+			&& calibration_match(sweep->card, &uid)) {
+
+			score.successes++;
+			score.latency += sweep->now() - start;
+		}
+	}
+
+	return score;
+}
+
+
+bool calibration_better(const Sweep_t *sweep, const Score_t *score) {
+	const Score_t *best = &sweep->score;
+
+	// More successes than by chance, a knob without effect is left alone
+	if (score->successes > best->successes + sweep->trials / 8) {
+		return true;
+	}
+
+	// Same successes: faster by more than timing jitter
+	return score->successes == best->successes && score->successes
+			&& score->latency + score->latency / 8 < best->latency;
+}
+
+
+bool calibration_match(const UID_t *card, const UID_t *uid) {
+	return card == NULL || (card->size == uid->size && memcmp(card->UID, uid->UID, uid->size) == 0);
+}
+
+/**************************** End of File ************************************/
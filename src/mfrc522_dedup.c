@@ -0,0 +1,168 @@
+
+//! \file mfrc522_dedup.c
+//! \brief Time-windowed suppression of repeated card reads
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_dedup.h"
+
+#include <string.h>
+
+
+#if (MFRC522_DEDUP_SLOTS & (MFRC522_DEDUP_SLOTS - 1)) || MFRC522_DEDUP_SLOTS > 128
+#error "MFRC522_DEDUP_SLOTS must be a power of 2, at most 128"
+#endif
+
+#if MFRC522_DEDUP_PROBES > MFRC522_DEDUP_SLOTS
+#error "MFRC522_DEDUP_PROBES must not exceed MFRC522_DEDUP_SLOTS"
+#endif
+
+#define NO_SLOT		0xFF
+
+
+typedef struct DedupSlot {
+	UID_t uid; // size 0 if free
+	uint32_t seen; // tick of the last read
+} DedupSlot_t;
+
+
+static DedupSlot_t slots[MFRC522_DEDUP_SLOTS];
+static DedupStats_t stats;
+
+static uint32_t window;
+static uint32_t (*now)(void);
+
+static uint8_t dedup_hash(const UID_t *uid);
+static uint8_t dedup_find(const UID_t *uid);
+static bool dedup_live(const DedupSlot_t *slot, uint32_t time);
+static bool dedup_equal(const UID_t *a, const UID_t *b);
+
+
+void mfrc522_dedupInit(uint32_t __window, uint32_t (*__now)(void)) {
+	window = __window;
+	now = __now;
+
+	for (uint8_t i = 0; i < MFRC522_DEDUP_SLOTS; i++) {
+		slots[i].uid.size = 0;
+	}
+
+	mfrc522_dedupResetStats();
+}
+
+
+bool mfrc522_dedupCheck(const UID_t *uid) {
+	uint32_t time = now();
+	uint8_t slot = dedup_find(uid);
+
+	if (slot != NO_SLOT && dedup_live(&slots[slot], time)) {
+		slots[slot].seen = time;
+		stats.suppressed++;
+		return false;
+	}
+
+	if (slot == NO_SLOT) {
+		// Reuse a free or expired slot, otherwise evict the least recently seen card
+		uint8_t first = dedup_hash(uid);
+		uint32_t oldest = 0;
+
+		for (uint8_t i = 0; i < MFRC522_DEDUP_PROBES; i++) {
+			uint8_t index = (first + i) & (MFRC522_DEDUP_SLOTS - 1);
+
+			if (!dedup_live(&slots[index], time)) {
+				slot = index;
+				break;
+			}
+
+			if (time - slots[index].seen >= oldest) {
+				oldest = time - slots[index].seen;
+				slot = index;
+			}
+		}
+
+		if (dedup_live(&slots[slot], time)) {
+			stats.evictions++;
+		}
+
+		slots[slot].uid = *uid;
+	}
+
+	slots[slot].seen = time;
+	stats.reported++;
+
+	// Occupancy is only needed for statistics, count it on reports
+	uint8_t live = 0;
+
+	for (uint8_t i = 0; i < MFRC522_DEDUP_SLOTS; i++) {
+		live += dedup_live(&slots[i], time);
+	}
+
+	stats.occupancy = live;
+
+	if (live > stats.maxOccupancy) {
+		stats.maxOccupancy = live;
+	}
+
+	return true;
+}
+
+
+void mfrc522_dedupForget(const UID_t *uid) {
+	uint8_t slot = dedup_find(uid);
+
+	if (slot != NO_SLOT) {
+		slots[slot].uid.size = 0;
+	}
+}
+
+
+void mfrc522_dedupGetStats(DedupStats_t *__stats) {
+	*__stats = stats;
+}
+
+
+void mfrc522_dedupResetStats() {
+	memset(&stats, 0, sizeof(stats));
+}
+
+/**************************** Helper functions *******************************/
+
+uint8_t dedup_hash(const UID_t *uid) {
+	// FNV-1a, low bits are enough for the table
+	uint32_t hash = 0x811C9DC5UL;
+
+	for (uint8_t i = 0; i < uid->size && i < sizeof(uid->UID); i++) {
+		hash ^= uid->UID[i];
+		hash *= 16777619UL;
+	}
+
+	return (hash ^ (hash >> 16)) & (MFRC522_DEDUP_SLOTS - 1);
+}
+
+
+uint8_t dedup_find(const UID_t *uid) {
+	uint8_t first = dedup_hash(uid);
+
+	// No deletion marks: a card is always within its probes
+	for (uint8_t i = 0; i < MFRC522_DEDUP_PROBES; i++) {
+		uint8_t index = (first + i) & (MFRC522_DEDUP_SLOTS - 1);
+
+		if (dedup_equal(&slots[index].uid, uid)) {
+			return index;
+		}
+	}
+
+	return NO_SLOT;
+}
+
+
+bool dedup_live(const DedupSlot_t *slot, uint32_t time) {
+	return slot->uid.size != 0 && time - slot->seen < window;
+}
+
+
+bool dedup_equal(const UID_t *a, const UID_t *b) {
+	return a->size != 0 && a->size == b->size && memcmp(a->UID, b->UID, a->size) == 0;
+}
+
+/**************************** End of File ************************************/
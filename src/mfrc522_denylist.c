@@ -0,0 +1,205 @@
+
+//! \file mfrc522_denylist.c
+//! \brief Bloom filter of revoked card UIDs, in EEPROM or flash.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_denylist.h"
+
+#include <stddef.h>
+
+
+// Header fields
+#define OFFSET_VERSION	4
+#define OFFSET_HASHES	5
+#define OFFSET_BITS		8
+#define OFFSET_SEED		12
+
+#define FNV_PRIME		16777619UL
+#define SECOND_SEED		0x9E3779B9UL
+
+
+typedef struct Filter {
+	uint32_t bits;
+	uint32_t seed;
+	uint8_t hashes;
+} Filter_t;
+
+static bool denylist_header(const DenylistMemory_t *memory, Filter_t *filter);
+static uint32_t denylist_word(const DenylistMemory_t *memory, uint32_t address);
+static void denylist_setWord(const DenylistMemory_t *memory, uint32_t address, uint32_t value);
+static uint32_t denylist_hash(uint32_t seed, const UID_t *uid);
+static uint32_t denylist_mix(uint32_t hash);
+static void denylist_positions(const Filter_t *filter, const UID_t *uid, uint32_t *position, uint32_t *step);
+
+
+bool mfrc522_denylistFormat(const DenylistMemory_t *memory, uint32_t bits, uint8_t hashes, uint32_t seed) {
+	if (memory->write == NULL || bits == 0 || hashes == 0 || hashes > DENYLIST_MAX_HASHES) {
+		return false;
+	}
+
+	memory->write(memory->context, 0, 'U');
+	memory->write(memory->context, 1, 'I');
+	memory->write(memory->context, 2, 'D');
+	memory->write(memory->context, 3, 'B');
+	memory->write(memory->context, OFFSET_VERSION, DENYLIST_VERSION);
+	memory->write(memory->context, OFFSET_HASHES, hashes);
+	memory->write(memory->context, 6, 0);
+	memory->write(memory->context, 7, 0);
+	denylist_setWord(memory, OFFSET_BITS, bits);
+	denylist_setWord(memory, OFFSET_SEED, seed);
+
+	// Set bits mean absent cards
+	for (uint32_t i = 0; i < (bits + 7) / 8; i++) {
+		memory->write(memory->context, DENYLIST_HEADER + i, 0xFF);
+	}
+
+	return true;
+}
+
+
+bool mfrc522_denylistValid(const DenylistMemory_t *memory) {
+	Filter_t filter;
+
+	return denylist_header(memory, &filter);
+}
+
+
+bool mfrc522_denylistAdd(const DenylistMemory_t *memory, const UID_t *uid) {
+	Filter_t filter;
+
+	if (memory->write == NULL || !denylist_header(memory, &filter)) {
+		return false;
+	}
+
+	uint32_t position, step;
+
+	denylist_positions(&filter, uid, &position, &step);
+
+	for (uint8_t i = 0; i < filter.hashes; i++) {
+		uint32_t address = DENYLIST_HEADER + position / 8;
+		uint8_t mask = 1 << (position % 8);
+		uint8_t value = memory->read(memory->context, address);
+
+		// Only clear bits, and only write bytes that change
+		if (value & mask) {
+			memory->write(memory->context, address, value & ~mask);
+		}
+
+		position += step;
+
+		if (position >= filter.bits) {
+			position -= filter.bits;
+		}
+	}
+
+	return true;
+}
+
+
+bool mfrc522_denylistCheck(const DenylistMemory_t *memory, const UID_t *uid) {
+	Filter_t filter;
+
+	// A broken filter must not let revoked cards in
+	if (!denylist_header(memory, &filter)) {
+		return true;
+	}
+
+	uint32_t position, step;
+
+	denylist_positions(&filter, uid, &position, &step);
+
+	for (uint8_t i = 0; i < filter.hashes; i++) {
+		uint8_t value = memory->read(memory->context, DENYLIST_HEADER + position / 8);
+
+		if (value & (1 << (position % 8))) {
+			return false;
+		}
+
+		position += step;
+
+		if (position >= filter.bits) {
+			position -= filter.bits;
+		}
+	}
+
+	return true;
+}
+
+/**************************** Helper functions *******************************/
+
+bool denylist_header(const DenylistMemory_t *memory, Filter_t *filter) {
+	if (memory->read(memory->context, 0) != 'U' || memory->read(memory->context, 1) != 'I'
+		|| memory->read(memory->context, 2) != 'D' || memory->read(memory->context, 3) != 'B'
+		|| memory->read(memory->context, OFFSET_VERSION) != DENYLIST_VERSION) {
+
+		return false;
+	}
+
+	filter->hashes = memory->read(memory->context, OFFSET_HASHES);
+	filter->bits = denylist_word(memory, OFFSET_BITS);
+	filter->seed = denylist_word(memory, OFFSET_SEED);
+
+	return filter->bits != 0 && filter->hashes != 0 && filter->hashes <= DENYLIST_MAX_HASHES;
+}
+
+
+uint32_t denylist_word(const DenylistMemory_t *memory, uint32_t address) {
+	uint32_t value = 0;
+
+	for (uint8_t i = 0; i < 4; i++) {
+		value |= (uint32_t)memory->read(memory->context, address + i) << (8 * i);
+	}
+
+	return value;
+}
+
+
+void denylist_setWord(const DenylistMemory_t *memory, uint32_t address, uint32_t value) {
+	for (uint8_t i = 0; i < 4; i++) {
+		memory->write(memory->context, address + i, value >> (8 * i));
+	}
+}
+
+
+uint32_t denylist_hash(uint32_t seed, const UID_t *uid) {
+	// FNV-1a of UID size and bytes
+	uint32_t hash = seed ^ uid->size;
+
+	hash *= FNV_PRIME;
+
+	for (uint8_t i = 0; i < uid->size && i < sizeof(uid->UID); i++) {
+		hash ^= uid->UID[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+
+uint32_t denylist_mix(uint32_t hash) {
+	// Finalizer of MurmurHash3, FNV alone leaves the two hashes correlated
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6BUL;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35UL;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+
+void denylist_positions(const Filter_t *filter, const UID_t *uid, uint32_t *position, uint32_t *step) {
+	uint32_t hash = denylist_hash(filter->seed, uid);
+
+	// Double hashing: position i is h1 + i*h2 modulo the number of bits
+	*position = denylist_mix(hash) % filter->bits;
+	*step = denylist_mix(hash ^ SECOND_SEED) % filter->bits;
+
+	if (*step == 0) {
+		*step = 1;
+	}
+}
+
+/**************************** End of File ************************************/
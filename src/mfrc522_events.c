@@ -0,0 +1,115 @@
+
+//! \file mfrc522_events.c
+//! \brief Debounced card arrival and removal events of MFRC522 reader
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_events.h"
+
+#include <string.h>
+
+
+static EventConfig_t config;
+static CardCallback_t callback;
+static void *context;
+static uint32_t (*now)(void);
+
+static UID_t card; // last card reported as arrived
+static bool tracking;
+static bool missing; // removal pending for debounce time
+static uint32_t missingSince;
+static uint32_t reported; // tick of last ARRIVED or PRESENT event
+
+static bool events_sameCard(const UID_t *uid);
+static void events_emit(PresenceEvent_t event, uint32_t time);
+
+
+void mfrc522_eventsInit(const EventConfig_t *__config, CardCallback_t __callback,
+						void *__context, uint32_t (*__now)(void)) {
+	config = *__config;
+	callback = __callback;
+	context = __context;
+	now = __now;
+	tracking = false;
+	missing = false;
+}
+
+
+bool mfrc522_eventsProcess() {
+	UID_t uid;
+	uint32_t time = now();
+	bool emitted = false;
+
+	switch (mfrc522_monitorPresence(&uid)) {
+		case PRESENCE_ARRIVED:
+			// Same card back within debounce time, it has never left
+			if (tracking && missing && events_sameCard(&uid)) {
+				missing = false;
+				break;
+			}
+
+			if (tracking) {
+				events_emit(PRESENCE_REMOVED, time);
+			}
+
+			card = uid;
+			tracking = true;
+			missing = false;
+			events_emit(PRESENCE_ARRIVED, time);
+			emitted = true;
+			break;
+
+		case PRESENCE_PRESENT:
+			if (config.rereport && time - reported >= config.rereport) {
+				events_emit(PRESENCE_PRESENT, time);
+				emitted = true;
+			}
+			break;
+
+		case PRESENCE_REMOVED:
+			missing = true;
+			missingSince = time;
+			break;
+
+		case PRESENCE_NONE:
+			break;
+	}
+
+	if (tracking && missing && time - missingSince >= config.debounce) {
+		events_emit(PRESENCE_REMOVED, time);
+		emitted = true;
+	}
+
+	return emitted;
+}
+
+
+bool mfrc522_eventsCard(UID_t *uid) {
+	if (tracking) {
+		*uid = card;
+	}
+
+	return tracking;
+}
+
+/**************************** Helper functions *******************************/
+
+bool events_sameCard(const UID_t *uid) {
+	return uid->size == card.size && memcmp(uid->UID, card.UID, card.size) == 0;
+}
+
+
+void events_emit(PresenceEvent_t event, uint32_t time) {
+	if (event == PRESENCE_REMOVED) {
+		tracking = false;
+		missing = false;
+	}
+	else {
+		reported = time;
+	}
+
+	callback(event, &card, context);
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,99 @@
+
+//! \file mfrc522_host.c
+//! \brief MFRC522 MIFARE RFID reader, platform layer for Linux host.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522.h"
+#include "mfrc522_port.h"
+
+#include "spi_host.h"
+#include "utils_host.h"
+
+
+// Reader in use, see mfrc522_port_bind()
+static HostPort_t single;
+static HostPort_t *bound = &single;
+
+// Clocks of mfrc522_negotiateClock()
+static const uint32_t CLOCKS[] = {1000000, 2000000, 4000000, 5000000, 8000000, MFRC522_SPI_MAX};
+
+
+uint8_t host_mfrc522_init(const SPIDevice_t *device, uint32_t speed) {
+	host_spi_master_init(device, speed);
+
+	single.device = device;
+	single.clock = speed;
+	mfrc522_port_bind(&single);
+
+	mfrc522_port_deselect();
+
+	return mfrc522_init();
+}
+
+
+uint8_t host_mfrc522_initReader(RFIDReader_t *reader, HostPort_t *port) {
+	mfrc522_attachReader(reader, port);
+
+	mfrc522_port_deselect();
+
+	return mfrc522_init();
+}
+
+
+void mfrc522_port_bind(void *port) {
+	bound = port;
+	host_spi_setDevice(bound->device);
+	host_spi_setClock(bound->clock);
+}
+
+
+void mfrc522_port_select() {
+	host_spi_select(true);
+}
+
+
+void mfrc522_port_deselect() {
+	host_spi_select(false);
+}
+
+
+void mfrc522_port_hardReset() {
+	// RST pin stays HIGH across host_mfrc522_init() calls,
+	// as across an MCU reset where the reader keeps power.
+	if (!bound->released) {
+		host_spi_reset(); // Wake MFRC522 up from hard power-down
+		bound->released = true;
+	}
+}
+
+
+void mfrc522_port_resetPulse() {
+	host_spi_reset();
+	bound->released = true;
+}
+
+
+uint32_t mfrc522_port_setClock(uint8_t step) {
+	if (step >= sizeof(CLOCKS) / sizeof(CLOCKS[0])) {
+		return 0;
+	}
+
+	host_spi_setClock(CLOCKS[step]);
+	bound->clock = CLOCKS[step];
+
+	return CLOCKS[step];
+}
+
+
+void mfrc522_port_delay(uint16_t ms) {
+	delay_ms(ms);
+}
+
+
+void mfrc522_port_delayUs(uint16_t us) {
+	delay_us(us);
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,132 @@
+
+//! \file mfrc522_queue.c
+//! \brief Lock-free queue of card events from ISR to main loop.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_queue.h"
+
+#if (MFRC522_QUEUE_SIZE & (MFRC522_QUEUE_SIZE - 1)) != 0
+#error "MFRC522_QUEUE_SIZE must be a power of 2"
+#endif
+
+#define MASK	(MFRC522_QUEUE_SIZE - 1)
+
+// Indexes run freely and are masked on access.
+// head is written by producer only, tail by consumer only.
+#if defined(__AVR__) || defined(__STDC_NO_ATOMICS__) || defined(MFRC522_QUEUE_NO_ATOMICS)
+
+#if MFRC522_QUEUE_SIZE > 128
+#error "MFRC522_QUEUE_SIZE must be at most 128 without C11 atomics"
+#endif
+
+// Single bytes are read and written atomically,
+// the barrier keeps the compiler from moving slot accesses across index accesses.
+#define BARRIER()	__asm__ __volatile__("" ::: "memory")
+
+typedef uint8_t QueueIndex_t;
+
+static volatile QueueIndex_t head;
+static volatile QueueIndex_t tail;
+static volatile uint16_t overflows;
+
+#define LOAD_RELAXED(index)			(index)
+#define LOAD_ACQUIRE(index)			queue_loadAcquire(&index)
+#define STORE_RELEASE(index, value)	do { BARRIER(); index = (value); } while (0)
+#define COUNT_OVERFLOW()			(overflows++)
+
+static inline QueueIndex_t queue_loadAcquire(volatile QueueIndex_t *index) {
+	QueueIndex_t value = *index;
+
+	BARRIER();
+	return value;
+}
+
+#else
+
+#include <stdatomic.h>
+
+typedef unsigned int QueueIndex_t;
+
+static atomic_uint head;
+static atomic_uint tail;
+static atomic_uint overflows;
+
+#define LOAD_RELAXED(index)			atomic_load_explicit(&index, memory_order_relaxed)
+#define LOAD_ACQUIRE(index)			atomic_load_explicit(&index, memory_order_acquire)
+#define STORE_RELEASE(index, value)	atomic_store_explicit(&index, value, memory_order_release)
+#define COUNT_OVERFLOW()			atomic_fetch_add_explicit(&overflows, 1, memory_order_relaxed)
+
+#endif
+
+
+static CardEvent_t ring[MFRC522_QUEUE_SIZE];
+static uint32_t (*now)(void);
+
+
+void mfrc522_queueInit(uint32_t (*__now)(void)) {
+	now = __now;
+	head = 0;
+	tail = 0;
+	overflows = 0;
+}
+
+
+bool mfrc522_queuePush(PresenceEvent_t event, const UID_t *uid) {
+	QueueIndex_t index = LOAD_RELAXED(head);
+
+	// Slot is free once consumer has published the tail after copying it
+	if ((QueueIndex_t)(index - LOAD_ACQUIRE(tail)) >= MFRC522_QUEUE_SIZE) {
+		COUNT_OVERFLOW();
+		return false;
+	}
+
+	CardEvent_t *slot = &ring[index & MASK];
+
+	slot->uid = *uid;
+	slot->time = now ? now() : 0;
+	slot->event = event;
+
+	STORE_RELEASE(head, (QueueIndex_t)(index + 1));
+	return true;
+}
+
+
+void mfrc522_queueCallback(PresenceEvent_t event, const UID_t *uid, void *context) {
+	(void)context;
+	mfrc522_queuePush(event, uid);
+}
+
+
+uint8_t mfrc522_queueDrain(CardEvent_t *events, uint8_t max) {
+	QueueIndex_t index = LOAD_RELAXED(tail);
+	QueueIndex_t end = LOAD_ACQUIRE(head);
+	uint8_t count = 0;
+
+	while (count < max && index != end) {
+		events[count++] = ring[index & MASK];
+		index++;
+	}
+
+	STORE_RELEASE(tail, index);
+	return count;
+}
+
+
+uint32_t mfrc522_queueOverflows(void) {
+#if defined(__AVR__) || defined(__STDC_NO_ATOMICS__) || defined(MFRC522_QUEUE_NO_ATOMICS)
+	// 16-bit counter may change between its two bytes, read until stable
+	uint16_t count;
+
+	do {
+		count = overflows;
+	} while (count != overflows);
+
+	return count;
+#else
+	return atomic_load_explicit(&overflows, memory_order_relaxed);
+#endif
+}
+
+/**************************** End of File ************************************/
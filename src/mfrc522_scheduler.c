@@ -0,0 +1,153 @@
+
+//! \file mfrc522_scheduler.c
+//! \brief Adaptive polling scheduler of MFRC522 reader
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_scheduler.h"
+#include "mfrc522.h"
+
+
+// Mean time between arrivals is an exponential moving average, weight 1/8
+#define GAP_SHIFT		3
+
+// Back-off is capped at gap / 4
+#define GAP_DIVIDER		4
+
+
+static SchedulerConfig_t config;
+static uint32_t (*now)(void);
+
+static uint32_t interval;
+static uint32_t next; // tick of next poll
+static uint32_t burstEnd;
+static uint32_t lastArrival;
+static uint32_t gap; // mean time between arrivals
+static uint32_t duration; // of last poll
+static bool seen; // a card answered the last poll
+static bool bursting;
+
+static void scheduler_arrival(uint32_t time);
+static uint32_t scheduler_ceiling();
+
+
+void mfrc522_schedulerInit(const SchedulerConfig_t *__config, uint32_t (*__now)(void)) {
+	config = *__config;
+	now = __now;
+
+	if (config.maxInterval < config.minInterval) {
+		config.maxInterval = config.minInterval;
+	}
+
+	interval = config.maxInterval;
+	next = now();
+	gap = config.maxInterval * GAP_DIVIDER;
+	lastArrival = next - gap;
+	duration = 0;
+	seen = false;
+	bursting = false;
+}
+
+
+bool mfrc522_schedulerAvailable() {
+	uint32_t start = now();
+
+	// Wrap-around safe comparison
+	if ((int32_t)(start - next) < 0) {
+		return false;
+	}
+
+	bool available = mfrc522_available();
+	uint32_t end = now();
+
+	duration = end - start;
+
+	if (available) {
+		if (!seen) {
+			scheduler_arrival(start);
+		}
+
+		bursting = true;
+		burstEnd = start + config.burst;
+		interval = config.minInterval;
+	}
+	else if (bursting && (int32_t)(start - burstEnd) < 0) {
+		interval = config.minInterval;
+	}
+	else {
+		// Idle field: exponential back-off
+		uint32_t ceiling = scheduler_ceiling();
+
+		bursting = false;
+		interval = (interval > ceiling / 2) ? ceiling : interval * 2;
+	}
+
+	seen = available;
+
+	// Intervals count from the start of polls, a late poll is not caught up
+	next = start + interval;
+
+	if ((int32_t)(end - next) > 0) {
+		next = end;
+	}
+
+	return available;
+}
+
+
+uint32_t mfrc522_schedulerWait() {
+	int32_t wait = next - now();
+
+	return (wait > 0) ? wait : 0;
+}
+
+
+uint32_t mfrc522_schedulerInterval() {
+	return interval;
+}
+
+
+uint32_t mfrc522_schedulerLatency(bool worst) {
+	return (worst ? interval : interval / 2) + duration;
+}
+
+/**************************** Helper functions *******************************/
+
+void scheduler_arrival(uint32_t time) {
+	uint32_t sample = time - lastArrival;
+
+	lastArrival = time;
+
+	// gap += (sample - gap) / 8, without signed overflow
+	if (sample > gap) {
+		gap += (sample - gap) >> GAP_SHIFT;
+	}
+	else {
+		gap -= (gap - sample) >> GAP_SHIFT;
+	}
+}
+
+
+uint32_t scheduler_ceiling() {
+	uint32_t ceiling = gap / GAP_DIVIDER;
+
+	// Time since last arrival lengthens the mean if cards stopped coming
+	uint32_t idle = (now() - lastArrival) / GAP_DIVIDER;
+
+	if (idle > ceiling) {
+		ceiling = idle;
+	}
+
+	if (ceiling < config.minInterval) {
+		return config.minInterval;
+	}
+
+	if (ceiling > config.maxInterval) {
+		return config.maxInterval;
+	}
+
+	return ceiling;
+}
+
+/**************************** End of File ************************************/
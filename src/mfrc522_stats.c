@@ -0,0 +1,182 @@
+
+//! \file mfrc522_stats.c
+//! \brief Runtime latency and error counters of MFRC522 driver.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_stats.h"
+
+#ifdef MFRC522_STATS
+
+#include "mfrc522_registers.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+
+static RFIDStats_t stats;
+static uint32_t (*now)(void);
+static uint32_t since; // last change of power state or snapshot
+static uint32_t sleepStart;
+static bool asleep;
+
+static uint8_t stats_classify(uint8_t command, const uint8_t *tx, uint8_t txSize);
+static uint8_t stats_bucket(uint32_t ticks);
+static void stats_elapse(uint32_t time);
+
+
+void mfrc522_statsInit(uint32_t (*__now)(void)) {
+	now = __now;
+	mfrc522_statsReset();
+}
+
+
+void mfrc522_statsSnapshot(RFIDStats_t *snapshot) {
+	stats_elapse(mfrc522_statsNow());
+	memcpy(snapshot, &stats, sizeof(stats));
+}
+
+
+void mfrc522_statsReset(void) {
+	memset(&stats, 0, sizeof(stats));
+	since = mfrc522_statsNow();
+}
+
+
+uint32_t mfrc522_statsAverageCurrent(const RFIDStats_t *snapshot,
+										uint32_t awakeCurrent, uint32_t asleepCurrent) {
+
+	uint64_t total = (uint64_t)snapshot->power.awake + snapshot->power.asleep;
+
+	if (total == 0) {
+		return awakeCurrent;
+	}
+
+	return ((uint64_t)snapshot->power.awake * awakeCurrent
+			+ (uint64_t)snapshot->power.asleep * asleepCurrent) / total;
+}
+
+
+uint32_t mfrc522_statsNow(void) {
+	return now ? now() : 0;
+}
+
+
+void mfrc522_statsRecord(uint8_t command, const void *txBuffer, uint8_t txSize,
+							uint8_t status, uint16_t polls, uint32_t start) {
+
+	FrameStats_t *frame = &stats.frame[stats_classify(command, txBuffer, txSize)];
+
+	if (status == STATUS_HUNG) {
+		status = MFRC522_STATS_HUNG;
+	}
+	else if (status >= MFRC522_STATS_HUNG) {
+		status = STATUS_INTERNAL_ERROR;
+	}
+
+	frame->status[status]++;
+	frame->polls += polls;
+
+	if (now) {
+		frame->latency[stats_bucket(now() - start)]++;
+	}
+}
+
+void mfrc522_statsSleep(void) {
+	sleepStart = mfrc522_statsNow();
+	stats_elapse(sleepStart);
+	asleep = true;
+}
+
+
+void mfrc522_statsWake(uint32_t start) {
+	uint32_t latency = mfrc522_statsNow() - start;
+
+	// Power-down lasts until the wake-up command, waiting for the oscillator is awake time
+	stats_elapse(start);
+	asleep = false;
+
+	if (start - sleepStart > stats.power.maxAsleep) {
+		stats.power.maxAsleep = start - sleepStart;
+	}
+
+	stats.power.wakeups++;
+	stats.power.latency[stats_bucket(latency)]++;
+
+	if (latency > stats.power.maxLatency) {
+		stats.power.maxLatency = latency;
+	}
+}
+
+/**************************** Helper functions *******************************/
+
+uint8_t stats_classify(uint8_t command, const uint8_t *tx, uint8_t txSize) {
+	if (command == MFRC522_CMD_AUTHENT) {
+		return STATS_AUTH;
+	}
+
+	if (command == MFRC522_CMD_CALCCRC) {
+		return STATS_CRC;
+	}
+
+	// Second step of WRITE: 16 bytes and CRC_A
+	if (txSize == 18) {
+		return STATS_WRITE;
+	}
+
+	if (txSize == 0) {
+		return STATS_OTHER;
+	}
+
+	switch (tx[0]) {
+		case MIFARE_CMD_REQA: case MIFARE_CMD_WUPA:
+			return STATS_REQUEST;
+
+		// NVB 0x70 means the whole UID part is sent
+		case MIFARE_CMD_SELECTCL1: case MIFARE_CMD_SELECTCL2: case MIFARE_CMD_SELECTCL3:
+			return (txSize > 1 && tx[1] == 0x70) ? STATS_SELECT : STATS_ANTICOLL;
+
+		case MIFARE_CMD_HALT:
+			return STATS_HALT;
+
+		case MIFARE_CMD_READ:
+			return STATS_READ;
+
+		case MIFARE_CMD_WRITE:
+			return STATS_WRITE;
+
+		default:
+			return STATS_OTHER;
+	}
+}
+
+
+void stats_elapse(uint32_t time) {
+	uint32_t elapsed = time - since;
+
+	since = time;
+
+	if (asleep) {
+		stats.power.asleep += elapsed;
+	}
+	else {
+		stats.power.awake += elapsed;
+	}
+}
+
+
+uint8_t stats_bucket(uint32_t ticks) {
+	uint8_t bucket = 0;
+
+	while (ticks > 1 && bucket < MFRC522_STATS_BUCKETS - 1) {
+		ticks >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+#endif
+
+/**************************** End of File ************************************/
@@ -0,0 +1,136 @@
+
+//! \file mfrc522_trace.c
+//! \brief Binary trace of MFRC522 register accesses and commands.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+
+
+#include "mfrc522_trace.h"
+
+#ifdef MFRC522_TRACE
+
+#if (MFRC522_TRACE_SIZE & (MFRC522_TRACE_SIZE - 1)) != 0
+#error "MFRC522_TRACE_SIZE must be a power of 2"
+#endif
+
+// Indexes run freely and are masked on access,
+// single byte ones are read and written atomically on AVR.
+#if MFRC522_TRACE_SIZE <= 128
+typedef uint8_t TraceIndex_t;
+#else
+typedef uint16_t TraceIndex_t;
+#endif
+
+#define MASK		(MFRC522_TRACE_SIZE - 1)
+
+// Keep the compiler from moving the event store after the head update
+#define BARRIER()	__asm__ __volatile__("" ::: "memory")
+
+
+static TraceEvent_t ring[MFRC522_TRACE_SIZE];
+static volatile TraceIndex_t head; // written by producer only
+static volatile TraceIndex_t tail; // written by consumer only
+static volatile uint16_t dropped;
+
+static uint32_t (*now)(void);
+static bool enabled;
+static uint8_t lastTag;
+static uint8_t lastValue;
+static uint8_t repeats;
+
+static void trace_push(uint8_t tag, uint8_t value);
+
+
+void mfrc522_traceInit(uint32_t (*__now)(void)) {
+	enabled = false;
+	now = __now;
+	head = tail = 0;
+	dropped = 0;
+	lastTag = TRACE_REPEAT;
+	repeats = 0;
+	enabled = true;
+}
+
+
+void mfrc522_traceEnable(bool enable) {
+	enabled = enable;
+}
+
+
+uint16_t mfrc522_traceRead(TraceEvent_t *events, uint16_t max) {
+	// Polls of the last busy-wait are counted once the next event arrives,
+	// which may never come before this drain
+	if (repeats) {
+		trace_push(TRACE_REPEAT, repeats);
+		repeats = 0;
+	}
+
+	TraceIndex_t index = tail;
+	uint16_t count = 0;
+
+	while (count < max && index != head) {
+		BARRIER();
+		events[count++] = ring[index & MASK];
+		index++;
+	}
+
+	BARRIER();
+	tail = index;
+
+	return count;
+}
+
+
+uint16_t mfrc522_traceDropped(void) {
+	return dropped;
+}
+
+
+void mfrc522_traceEvent(uint8_t tag, uint8_t value) {
+	if (!enabled) {
+		return;
+	}
+
+	// Collapse busy-wait polls
+	if ((tag & TRACE_TYPE) == TRACE_READ && tag == lastTag && value == lastValue) {
+		if (++repeats == 0xFF) {
+			trace_push(TRACE_REPEAT, repeats);
+			repeats = 0;
+		}
+
+		return;
+	}
+
+	if (repeats) {
+		trace_push(TRACE_REPEAT, repeats);
+		repeats = 0;
+	}
+
+	lastTag = tag;
+	lastValue = value;
+	trace_push(tag, value);
+}
+
+/**************************** Helper functions *******************************/
+
+void trace_push(uint8_t tag, uint8_t value) {
+	TraceIndex_t index = head;
+
+	if ((TraceIndex_t)(index - tail) >= MFRC522_TRACE_SIZE) {
+		dropped++;
+		return;
+	}
+
+	TraceEvent_t *event = &ring[index & MASK];
+
+	event->time = now ? now() : 0;
+	event->tag = tag;
+	event->value = value;
+
+	BARRIER();
+	head = index + 1;
+}
+
+#endif
+
+/**************************** End of File ************************************/
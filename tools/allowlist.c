@@ -0,0 +1,399 @@
+
+//! \file allowlist.c
+//! \brief Build and verify a UID index of mfrc522_allowlist.h from a CSV file.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Usage: mfrc522_allowlist [-n name] [-c source.c] [-b blob.bin] cards.csv
+//!
+//! CSV: one card per line, "UID[,record]". UID is 4, 7 or 10 bytes in hex,
+//! ':', '-' and spaces between bytes are ignored. Record is decimal, or hex
+//! with 0x, and defaults to the card number in the file, from 0. '#' starts a
+//! comment, a first line that is not a UID is a header.
+//!
+//! The index is written as a C source defining "const uint8_t name[] PROGMEM",
+//! and/or as a binary blob. It is then verified with mfrc522_allowlistLookup():
+//! every card must be found with its record, random and neighbouring UIDs must not.
+//! Exit code is 1 if the CSV is invalid or verification failed.
+
+
+#include "mfrc522_allowlist.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define MAX_LINE	256
+#define RANDOM_UIDS	100000
+
+
+typedef struct Card {
+	UID_t uid;
+	uint16_t record;
+	uint32_t line;
+} Card_t;
+
+
+static const uint8_t SIZES[3] = {4, 7, 10};
+
+static Card_t *cards;
+static uint32_t cardCount;
+
+static bool parseCSV(const char *path);
+static bool parseUID(const char *text, UID_t *uid);
+static int compareCards(const void *a, const void *b);
+static uint8_t* buildBlob(uint32_t *size);
+static bool writeSource(const char *path, const char *name, const char *csv, const uint8_t *blob, uint32_t size);
+static bool verify(const uint8_t *blob);
+static bool isEnrolled(const UID_t *uid);
+
+
+int main(int argc, char **argv) {
+	const char *name = "allowlist";
+	const char *sourcePath = NULL;
+	const char *blobPath = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:c:b:")) != -1) {
+		switch (opt) {
+			case 'n':	name = optarg; break;
+			case 'c':	sourcePath = optarg; break;
+			case 'b':	blobPath = optarg; break;
+			default:
+				fprintf(stderr, "Usage: %s [-n name] [-c source.c] [-b blob.bin] cards.csv\n", argv[0]);
+				return 2;
+		}
+	}
+
+	if (optind >= argc) {
+		fprintf(stderr, "Usage: %s [-n name] [-c source.c] [-b blob.bin] cards.csv\n", argv[0]);
+		return 2;
+	}
+
+	if (!parseCSV(argv[optind])) {
+		return 1;
+	}
+
+	qsort(cards, cardCount, sizeof(Card_t), compareCards);
+
+	for (uint32_t i = 1; i < cardCount; i++) {
+		if (compareCards(&cards[i-1], &cards[i]) == 0) {
+			fprintf(stderr, "%s:%u: duplicate of line %u\n", argv[optind], cards[i].line, cards[i-1].line);
+			return 1;
+		}
+	}
+
+	uint32_t size;
+	uint8_t *blob = buildBlob(&size);
+
+	if (sourcePath && !writeSource(sourcePath, name, argv[optind], blob, size)) {
+		fprintf(stderr, "Cannot write %s\n", sourcePath);
+		return 1;
+	}
+
+	if (blobPath) {
+		FILE *file = fopen(blobPath, "wb");
+
+		if (file == NULL || fwrite(blob, 1, size, file) != size) {
+			fprintf(stderr, "Cannot write %s\n", blobPath);
+			return 1;
+		}
+
+		fclose(file);
+	}
+
+	printf("%u cards, %u bytes\n", cardCount, size);
+
+	bool valid = verify(blob);
+
+	free(blob);
+	free(cards);
+
+	return valid ? 0 : 1;
+}
+
+
+bool parseCSV(const char *path) {
+	FILE *file = fopen(path, "r");
+	char line[MAX_LINE];
+	uint32_t number = 0;
+	uint32_t capacity = 0;
+
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open %s\n", path);
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		number++;
+
+		char *comment = strchr(line, '#');
+
+		if (comment) {
+			*comment = '\0';
+		}
+
+		char *record = strchr(line, ',');
+
+		if (record) {
+			*record++ = '\0';
+		}
+
+		// Skip empty lines
+		char *text = line;
+
+		while (isspace((unsigned char)*text)) {
+			text++;
+		}
+
+		if (*text == '\0') {
+			continue;
+		}
+
+		if (cardCount == capacity) {
+			capacity = capacity ? 2 * capacity : 1024;
+			cards = realloc(cards, capacity * sizeof(Card_t));
+		}
+
+		Card_t *card = &cards[cardCount];
+
+		if (!parseUID(text, &card->uid)) {
+			if (number == 1) {
+				continue; // header
+			}
+
+			fprintf(stderr, "%s:%u: invalid UID\n", path, number);
+			fclose(file);
+			return false;
+		}
+
+		unsigned long value = cardCount;
+
+		if (record) {
+			char *digits = record;
+			char *end;
+			int base = 10;
+
+			while (isspace((unsigned char)*digits)) {
+				digits++;
+			}
+
+			// Decimal, zero-padded numbers of spreadsheets included, or 0x hex
+			if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+				digits += 2;
+				base = 16;
+			}
+
+			// strtoul() would take a sign or spaces after 0x
+			bool valid = (base == 16) ? isxdigit((unsigned char)*digits)
+									  : isdigit((unsigned char)*digits);
+
+			value = strtoul(digits, &end, base);
+
+			while (isspace((unsigned char)*end)) {
+				end++;
+			}
+
+			if (!valid || *end != '\0') {
+				fprintf(stderr, "%s:%u: invalid record\n", path, number);
+				fclose(file);
+				return false;
+			}
+		}
+
+		if (value >= ALLOWLIST_NOT_FOUND) {
+			fprintf(stderr, "%s:%u: record must be below %u\n", path, number, ALLOWLIST_NOT_FOUND);
+			fclose(file);
+			return false;
+		}
+
+		card->record = value;
+		card->line = number;
+		cardCount++;
+	}
+
+	fclose(file);
+
+	if (cardCount >= ALLOWLIST_NOT_FOUND) {
+		fprintf(stderr, "%s: too many cards\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+
+bool parseUID(const char *text, UID_t *uid) {
+	uint8_t digits = 0;
+
+	memset(uid, 0, sizeof(UID_t));
+
+	for (; *text; text++) {
+		if (*text == ':' || *text == '-' || isspace((unsigned char)*text)) {
+			continue;
+		}
+
+		if (!isxdigit((unsigned char)*text) || digits == 2 * sizeof(uid->UID)) {
+			return false;
+		}
+
+		uint8_t nibble = isdigit((unsigned char)*text) ? *text - '0' : (tolower(*text) - 'a' + 10);
+
+		uid->UID[digits / 2] |= (digits % 2) ? nibble : nibble << 4;
+		digits++;
+	}
+
+	uid->size = digits / 2;
+
+	return (digits % 2) == 0 && (uid->size == 4 || uid->size == 7 || uid->size == 10);
+}
+
+
+int compareCards(const void *a, const void *b) {
+	const UID_t *x = &((const Card_t*)a)->uid;
+	const UID_t *y = &((const Card_t*)b)->uid;
+
+	// Tables by size, then bytewise order
+	if (x->size != y->size) {
+		return (x->size < y->size) ? -1 : 1;
+	}
+
+	return memcmp(x->UID, y->UID, x->size);
+}
+
+
+uint8_t* buildBlob(uint32_t *size) {
+	uint16_t counts[3] = {0};
+	uint32_t bytes = ALLOWLIST_HEADER;
+
+	for (uint32_t i = 0; i < cardCount; i++) {
+		for (uint8_t t = 0; t < 3; t++) {
+			if (cards[i].uid.size == SIZES[t]) {
+				counts[t]++;
+			}
+		}
+
+		bytes += cards[i].uid.size + 2;
+	}
+
+	uint8_t *blob = calloc(bytes, 1);
+	uint8_t *p = blob + ALLOWLIST_HEADER;
+
+	memcpy(blob, "UIDX", 4);
+	blob[4] = ALLOWLIST_VERSION;
+
+	for (uint8_t t = 0; t < 3; t++) {
+		blob[6 + 2*t] = counts[t] & 0xFF;
+		blob[7 + 2*t] = counts[t] >> 8;
+	}
+
+	// Cards are sorted by size, so tables follow each other
+	for (uint32_t i = 0; i < cardCount; i++) {
+		memcpy(p, cards[i].uid.UID, cards[i].uid.size);
+		p += cards[i].uid.size;
+	}
+
+	for (uint32_t i = 0; i < cardCount; i++) {
+		*p++ = cards[i].record & 0xFF;
+		*p++ = cards[i].record >> 8;
+	}
+
+	uint16_t crc = 0xFFFF;
+
+	for (uint32_t i = ALLOWLIST_HEADER; i < bytes; i++) {
+		crc ^= (uint16_t)blob[i] << 8;
+
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+
+	blob[12] = crc & 0xFF;
+	blob[13] = crc >> 8;
+
+	*size = bytes;
+	return blob;
+}
+
+
+bool writeSource(const char *path, const char *name, const char *csv, const uint8_t *blob, uint32_t size) {
+	FILE *file = fopen(path, "w");
+
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "\n// Generated by mfrc522_allowlist from %s, do not edit.\n", csv);
+	fprintf(file, "// %u cards, see mfrc522_allowlist.h\n\n", cardCount);
+	fprintf(file, "#include \"mfrc522_allowlist.h\"\n\n\n");
+	fprintf(file, "const uint8_t %s[%u] PROGMEM = {", name, size);
+
+	for (uint32_t i = 0; i < size; i++) {
+		fprintf(file, "%s0x%02X%s", (i % 16) ? " " : "\n\t", blob[i], (i + 1 < size) ? "," : "");
+	}
+
+	fprintf(file, "\n};\n");
+
+	return fclose(file) == 0;
+}
+
+
+bool verify(const uint8_t *blob) {
+	uint32_t errors = 0;
+	uint32_t rejected = 0;
+
+	if (!mfrc522_allowlistCheck(blob) || mfrc522_allowlistCount(blob) != cardCount) {
+		printf("invalid header or CRC\n");
+		return false;
+	}
+
+	for (uint32_t i = 0; i < cardCount; i++) {
+		if (mfrc522_allowlistLookup(blob, &cards[i].uid) != cards[i].record) {
+			errors++;
+		}
+
+		// Neighbours of an enrolled UID
+		for (int8_t delta = -1; delta <= 1; delta += 2) {
+			UID_t uid = cards[i].uid;
+
+			uid.UID[uid.size - 1] += delta;
+
+			if (!isEnrolled(&uid)) {
+				rejected++;
+				errors += (mfrc522_allowlistLookup(blob, &uid) != ALLOWLIST_NOT_FOUND);
+			}
+		}
+	}
+
+	srand(1);
+
+	for (uint32_t i = 0; i < RANDOM_UIDS; i++) {
+		UID_t uid = {.size = SIZES[rand() % 3]};
+
+		for (uint8_t b = 0; b < uid.size; b++) {
+			uid.UID[b] = rand();
+		}
+
+		if (!isEnrolled(&uid)) {
+			rejected++;
+			errors += (mfrc522_allowlistLookup(blob, &uid) != ALLOWLIST_NOT_FOUND);
+		}
+	}
+
+	printf("verified %u cards, %u unknown UIDs: %s\n", cardCount, rejected,
+			errors ? "FAILED" : "ok");
+
+	return errors == 0;
+}
+
+
+bool isEnrolled(const UID_t *uid) {
+	Card_t key = {.uid = *uid};
+
+	return bsearch(&key, cards, cardCount, sizeof(Card_t), compareCards) != NULL;
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,432 @@
+
+//! \file benchmark.c
+//! \brief SPI transaction and air-time benchmark of MFRC522 driver, with regression budgets.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Every scenario runs the driver against the simulator through a counting
+//! SPI device, and is compared to the budget file.
+//!
+//! Usage: mfrc522_benchmark [-c clock_hz] [-b budget_file] [-j json_file]
+//!
+//! Budget file: "clock <Hz>" once, then one line per scenario:
+//! "<name> <frames> <bytes> <reads> <polls> <time_us>", '#' starts a comment.
+//! Exit code is 1 if any scenario exceeds its budget.
+
+
+#include "mfrc522.h"
+#include "mfrc522_sim.h"
+#include "mfrc522_status.h"
+#include "mfrc522_registers.h"
+#include "utils_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define MAX_SCENARIOS	16
+
+
+typedef struct Counters {
+	uint32_t frames; // SS assertions
+	uint32_t bytes; // SPI bytes
+	uint32_t reads; // register reads, FIFO bytes included
+	uint32_t polls; // re-reads of ComIrqReg/DivIrqReg/CommandReg while waiting
+	uint64_t time_ns; // virtual wall time
+} Counters_t;
+
+
+typedef struct Budget {
+	char name[32];
+	uint32_t frames;
+	uint32_t bytes;
+	uint32_t reads;
+	uint32_t polls;
+	uint32_t time_us;
+} Budget_t;
+
+
+typedef struct Scenario {
+	const char *name;
+	void (*setup)(void); // not measured
+	uint8_t (*run)(void); // measured
+} Scenario_t;
+
+
+static const SPIDevice_t *sim;
+static Counters_t counters;
+static bool firstByte;
+static bool reading;
+static uint8_t address;
+static uint8_t lastRead;
+static uint32_t spiClock;
+static bool absent; // reader not connected, MISO reads 0x00
+
+static SimCard_t classic, classic2, ultralight, ultralight2;
+static UID_t uid;
+
+static void count_select(void *context, bool selected);
+static uint8_t count_transfer(void *context, uint8_t data);
+static void count_reset(void *context);
+
+static const SPIDevice_t counting = {
+	.select = count_select,
+	.transfer = count_transfer,
+	.reset = count_reset,
+	.context = NULL
+};
+
+static void field(SimCard_t *first, SimCard_t *second);
+static void setup_empty(void);
+static void setup_card(void);
+static void setup_4byte(void);
+static void setup_7byte(void);
+static void setup_4byte_collision(void);
+static void setup_7byte_collision(void);
+static void setup_selected(void);
+static void setup_lowPower(void);
+static void setup_powerOn(void);
+static void setup_warm(void);
+static void setup_absent(void);
+static void setup_brownout(void);
+static uint8_t run_available(void);
+static uint8_t run_getID(void);
+static uint8_t run_sendHaltA(void);
+static uint8_t run_init(void);
+static uint8_t loadBudgets(const char *path, Budget_t *budgets, uint32_t *clock);
+
+static const Scenario_t scenarios[] = {
+	{"available_empty", setup_empty, run_available},
+	{"available_4byte", setup_card, run_available},
+	{"getID_4byte", setup_4byte, run_getID},
+	{"getID_7byte", setup_7byte, run_getID},
+	{"getID_4byte_collision", setup_4byte_collision, run_getID},
+	{"getID_7byte_collision", setup_7byte_collision, run_getID},
+	{"sendHaltA", setup_selected, run_sendHaltA},
+	{"available_lowpower", setup_lowPower, run_available},
+	{"startup_cold", setup_powerOn, run_init},
+	{"startup_warm", setup_warm, run_init},
+	{"startup_absent", setup_absent, run_init},
+	{"recover_brownout", setup_brownout, run_available},
+};
+
+#define SCENARIO_COUNT	(sizeof(scenarios) / sizeof(scenarios[0]))
+
+
+int main(int argc, char **argv) {
+	const char *budgetPath = NULL;
+	const char *jsonPath = NULL;
+	uint32_t clock = 0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:b:j:")) != -1) {
+		switch (opt) {
+			case 'c':	clock = strtoul(optarg, NULL, 0); break;
+			case 'b':	budgetPath = optarg; break;
+			case 'j':	jsonPath = optarg; break;
+			default:
+				fprintf(stderr, "Usage: %s [-c clock_hz] [-b budget_file] [-j json_file]\n", argv[0]);
+				return 2;
+		}
+	}
+
+	Budget_t budgets[MAX_SCENARIOS];
+	uint32_t budgetClock = 4000000;
+	uint8_t budgetCount = 0;
+
+	if (budgetPath) {
+		budgetCount = loadBudgets(budgetPath, budgets, &budgetClock);
+	}
+
+	if (clock == 0) {
+		clock = budgetClock;
+	}
+
+	// Budgets are only meaningful at their own clock.
+	if (clock != budgetClock) {
+		budgetCount = 0;
+	}
+
+	static const uint8_t uid4[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+	static const uint8_t uid4b[4] = {0xDE, 0xAD, 0x3E, 0x01};
+	static const uint8_t uid7[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+	static const uint8_t uid7b[7] = {0x04, 0x11, 0x22, 0x33, 0xC4, 0x55, 0x66};
+
+	mfrc522_sim_createCard(&classic, SIM_CARD_CLASSIC_1K, uid4, 4);
+	mfrc522_sim_createCard(&classic2, SIM_CARD_CLASSIC_1K, uid4b, 4);
+	mfrc522_sim_createCard(&ultralight, SIM_CARD_ULTRALIGHT, uid7, 7);
+	mfrc522_sim_createCard(&ultralight2, SIM_CARD_ULTRALIGHT, uid7b, 7);
+
+	spiClock = clock;
+	sim = mfrc522_sim_device();
+	mfrc522_sim_init();
+	host_mfrc522_init(&counting, clock);
+
+	FILE *json = jsonPath ? fopen(jsonPath, "w") : NULL;
+
+	if (json) {
+		fprintf(json, "{\n  \"clock_hz\": %u,\n  \"scenarios\": [\n", clock);
+	}
+
+	printf("SPI clock: %u Hz\n\n", clock);
+	printf("%-24s %6s %8s %8s %8s %8s %10s  %s\n",
+			"scenario", "status", "frames", "bytes", "reads", "polls", "time_us", "budget");
+
+	int failures = 0;
+
+	for (uint8_t i = 0; i < SCENARIO_COUNT; i++) {
+		const Scenario_t *scenario = &scenarios[i];
+
+		scenario->setup();
+
+		memset(&counters, 0, sizeof(counters));
+		lastRead = 0xFF;
+		uint64_t start = host_time_ns();
+		uint8_t status = scenario->run();
+		counters.time_ns = host_time_ns() - start;
+
+		const char *verdict = "-";
+		uint32_t time_us = counters.time_ns / 1000;
+
+		for (uint8_t j = 0; j < budgetCount; j++) {
+			const Budget_t *max = &budgets[j];
+
+			if (strcmp(max->name, scenario->name) != 0) {
+				continue;
+			}
+
+			verdict = "ok";
+
+			if (counters.frames > max->frames || counters.bytes > max->bytes
+				|| counters.reads > max->reads || counters.polls > max->polls
+				|| time_us > max->time_us) {
+
+				verdict = "EXCEEDED";
+				failures++;
+			}
+		}
+
+		printf("%-24s %6u %8u %8u %8u %8u %10u  %s\n",
+				scenario->name, status, counters.frames, counters.bytes,
+				counters.reads, counters.polls, time_us, verdict);
+
+		if (json) {
+			fprintf(json, "    {\"name\": \"%s\", \"status\": %u, \"frames\": %u, \"bytes\": %u, "
+							"\"reads\": %u, \"polls\": %u, \"time_us\": %u, \"budget\": \"%s\"}%s\n",
+					scenario->name, status, counters.frames, counters.bytes,
+					counters.reads, counters.polls, time_us, verdict,
+					(i + 1 < SCENARIO_COUNT) ? "," : "");
+		}
+	}
+
+	if (json) {
+		fprintf(json, "  ],\n  \"failures\": %d\n}\n", failures);
+		fclose(json);
+	}
+
+	if (failures) {
+		printf("\n%d scenario(s) exceeded budget.\n", failures);
+		return 1;
+	}
+
+	return 0;
+}
+
+/**************************** Counting device ********************************/
+
+void count_select(void *context, bool selected) {
+	if (selected) {
+		counters.frames++;
+		firstByte = true;
+	}
+
+	sim->select(sim->context, selected);
+}
+
+
+uint8_t count_transfer(void *context, uint8_t data) {
+	counters.bytes++;
+
+	if (firstByte) {
+		firstByte = false;
+		reading = data & 0x80;
+		address = (data >> 1) & 0x3F;
+
+		// Any write ends a busy-wait loop.
+		if (!reading) {
+			lastRead = 0xFF;
+		}
+	}
+	else if (reading) {
+		counters.reads++;
+
+		bool status = (address == ComIrqReg || address == DivIrqReg || address == CommandReg);
+
+		if (status && address == lastRead) {
+			counters.polls++;
+		}
+
+		lastRead = address;
+		address = (data >> 1) & 0x3F;
+	}
+
+	if (absent) {
+		return 0x00;
+	}
+
+	return sim->transfer(sim->context, data);
+}
+
+
+void count_reset(void *context) {
+	sim->reset(sim->context);
+}
+
+/**************************** Scenarios **************************************/
+
+void field(SimCard_t *first, SimCard_t *second) {
+	mfrc522_sim_clearField();
+
+	if (first) {
+		mfrc522_sim_addCard(first);
+	}
+
+	if (second) {
+		mfrc522_sim_addCard(second);
+	}
+}
+
+
+void setup_empty(void) {
+	field(NULL, NULL);
+}
+
+
+void setup_card(void) {
+	field(&classic, NULL);
+}
+
+
+void setup_4byte(void) {
+	field(&classic, NULL);
+	mfrc522_available();
+}
+
+
+void setup_7byte(void) {
+	field(&ultralight, NULL);
+	mfrc522_available();
+}
+
+
+void setup_4byte_collision(void) {
+	field(&classic, &classic2);
+	mfrc522_available();
+}
+
+
+void setup_7byte_collision(void) {
+	field(&ultralight, &ultralight2);
+	mfrc522_available();
+}
+
+
+void setup_selected(void) {
+	field(&classic, NULL);
+	mfrc522_available();
+	mfrc522_getID(&uid);
+}
+
+
+// Empty field, reader in soft power-down between polls
+void setup_lowPower(void) {
+	static const LowPower_t config = {.guard = 5000, .window = 1000};
+
+	field(NULL, NULL);
+	mfrc522_setLowPower(&config);
+}
+
+
+// Reader just powered, as at board power-up
+void setup_powerOn(void) {
+	mfrc522_setLowPower(NULL);
+	field(NULL, NULL);
+	mfrc522_sim_init();
+}
+
+
+// MCU restarted, reader kept its power and configuration
+void setup_warm(void) {
+	field(NULL, NULL);
+}
+
+
+void setup_absent(void) {
+	absent = true;
+}
+
+
+// Reader lost its configuration behind the driver's back: the timer does not
+// run, REQA waits for its deadline and the reader is recovered.
+void setup_brownout(void) {
+	absent = false;
+	field(NULL, NULL);
+	mfrc522_sim_init();
+	host_time_advance(1000000); // oscillator is stable
+}
+
+
+uint8_t run_available(void) {
+	return mfrc522_available() ? STATUS_OK : STATUS_TIMEOUT;
+}
+
+
+uint8_t run_getID(void) {
+	return mfrc522_getID(&uid);
+}
+
+
+uint8_t run_sendHaltA(void) {
+	return mfrc522_sendHaltA();
+}
+
+
+uint8_t run_init(void) {
+	return host_mfrc522_init(&counting, spiClock);
+}
+
+
+uint8_t loadBudgets(const char *path, Budget_t *budgets, uint32_t *clock) {
+	FILE *file = fopen(path, "r");
+	char line[128];
+	uint8_t count = 0;
+
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open budget file %s\n", path);
+		exit(2);
+	}
+
+	while (fgets(line, sizeof(line), file) && count < MAX_SCENARIOS) {
+		Budget_t *budget = &budgets[count];
+
+		if (line[0] == '#' || line[0] == '\n') {
+			continue;
+		}
+
+		if (sscanf(line, "clock %u", clock) == 1) {
+			continue;
+		}
+
+		if (sscanf(line, "%31s %u %u %u %u %u", budget->name, &budget->frames,
+					&budget->bytes, &budget->reads, &budget->polls, &budget->time_us) == 6) {
+			count++;
+		}
+	}
+
+	fclose(file);
+	return count;
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,445 @@
+
+//! \file denylist.c
+//! \brief Build a Bloom filter of mfrc522_denylist.h from a CSV file of revoked cards.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Usage: mfrc522_denylist [-p rate] [-N capacity] [-d old.bin] [-P page]
+//!                         [-n name] [-c source.c] [-b filter.bin] revoked.csv
+//!        mfrc522_denylist -q revoked.csv UID...
+//!
+//! CSV: one revoked card per line, UID is 4, 7 or 10 bytes in hex, ':', '-'
+//! and spaces between bytes are ignored, other columns are ignored. '#' starts
+//! a comment, a first line that is not a UID is a header.
+//!
+//! The filter is sized for a false-positive rate (-p, default 0.01) at a number
+//! of cards (-N, default the cards of the CSV; leave room for cards added in
+//! place by mfrc522_denylistAdd()). With -d, the geometry of the filter in place
+//! is kept and the pages (-P bytes, default 256) to rewrite are reported.
+//!
+//! The filter is written as a C source defining "const uint8_t name[] PROGMEM",
+//! and/or as a binary. It is then verified: no revoked card may pass, and the
+//! false-positive rate is measured on random UIDs.
+//!
+//! With -q, the UIDs given are checked exactly against the CSV, to confirm the
+//! positives of the filter. Exit code is 0 if all are revoked.
+//!
+//! Exit code is 1 if the CSV is invalid or verification failed.
+
+
+#include "mfrc522_denylist.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define MAX_LINE	256
+#define RANDOM_UIDS	100000
+
+
+typedef struct Buffer {
+	uint8_t *data;
+	uint32_t size;
+} Buffer_t;
+
+
+static const uint8_t SIZES[3] = {4, 7, 10};
+
+static UID_t *cards;
+static uint32_t cardCount;
+
+static bool parseCSV(const char *path);
+static bool parseUID(const char *text, UID_t *uid);
+static int compareUIDs(const void *a, const void *b);
+static bool isRevoked(const UID_t *uid);
+static uint8_t readBuffer(void *context, uint32_t address);
+static void writeBuffer(void *context, uint32_t address, uint8_t value);
+static bool loadFilter(const char *path, Buffer_t *buffer);
+static uint32_t readWord(const uint8_t *data);
+static void reportPages(const Buffer_t *old, const Buffer_t *filter, uint32_t page);
+static bool writeSource(const char *path, const char *name, const char *csv, const Buffer_t *filter);
+static bool verify(const DenylistMemory_t *memory, double rate);
+static int query(int count, char **uids);
+
+
+int main(int argc, char **argv) {
+	const char *usage = "Usage: %s [-p rate] [-N capacity] [-d old.bin] [-P page]"
+						" [-n name] [-c source.c] [-b filter.bin] revoked.csv\n"
+						"       %s -q revoked.csv UID...\n";
+	const char *name = "denylist";
+	const char *sourcePath = NULL;
+	const char *filterPath = NULL;
+	const char *oldPath = NULL;
+	double rate = 0.01;
+	uint32_t capacity = 0;
+	uint32_t page = 256;
+	bool exact = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "p:N:d:P:n:c:b:q")) != -1) {
+		switch (opt) {
+			case 'p':	rate = atof(optarg); break;
+			case 'N':	capacity = strtoul(optarg, NULL, 0); break;
+			case 'd':	oldPath = optarg; break;
+			case 'P':	page = strtoul(optarg, NULL, 0); break;
+			case 'n':	name = optarg; break;
+			case 'c':	sourcePath = optarg; break;
+			case 'b':	filterPath = optarg; break;
+			case 'q':	exact = true; break;
+			default:
+				fprintf(stderr, usage, argv[0], argv[0]);
+				return 2;
+		}
+	}
+
+	if (optind >= argc || rate <= 0 || rate >= 1 || page == 0) {
+		fprintf(stderr, usage, argv[0], argv[0]);
+		return 2;
+	}
+
+	if (!parseCSV(argv[optind])) {
+		return 1;
+	}
+
+	qsort(cards, cardCount, sizeof(UID_t), compareUIDs);
+
+	if (exact) {
+		return query(argc - optind - 1, argv + optind + 1);
+	}
+
+	Buffer_t old = {NULL, 0};
+	uint32_t bits;
+	uint8_t hashes;
+	uint32_t seed;
+
+	if (oldPath) {
+		if (!loadFilter(oldPath, &old)) {
+			fprintf(stderr, "%s: not a valid filter\n", oldPath);
+			return 1;
+		}
+
+		// Same positions for the same cards, so unchanged pages stay as they are
+		hashes = old.data[5];
+		bits = readWord(old.data + 8);
+		seed = readWord(old.data + 12);
+	}
+	else {
+		// Optimal size and number of hashes for n cards at rate p:
+		// m = -n ln(p) / ln(2)^2, k = m / n ln(2)
+		double n = (capacity > cardCount) ? capacity : (cardCount ? cardCount : 1);
+		double m = ceil(-n * log(rate) / (M_LN2 * M_LN2));
+		long k = lround(m / n * M_LN2);
+
+		bits = (uint32_t)m;
+		hashes = (k < 1) ? 1 : (k > DENYLIST_MAX_HASHES) ? DENYLIST_MAX_HASHES : k;
+		seed = 0x811C9DC5UL;
+	}
+
+	Buffer_t filter = {NULL, DENYLIST_HEADER + (bits + 7) / 8};
+	DenylistMemory_t memory = {readBuffer, writeBuffer, &filter};
+
+	filter.data = malloc(filter.size);
+
+	if (!mfrc522_denylistFormat(&memory, bits, hashes, seed)) {
+		fprintf(stderr, "Invalid filter geometry\n");
+		return 1;
+	}
+
+	for (uint32_t i = 0; i < cardCount; i++) {
+		mfrc522_denylistAdd(&memory, &cards[i]);
+	}
+
+	if (sourcePath && !writeSource(sourcePath, name, argv[optind], &filter)) {
+		fprintf(stderr, "Cannot write %s\n", sourcePath);
+		return 1;
+	}
+
+	if (filterPath) {
+		FILE *file = fopen(filterPath, "wb");
+
+		if (file == NULL || fwrite(filter.data, 1, filter.size, file) != filter.size) {
+			fprintf(stderr, "Cannot write %s\n", filterPath);
+			return 1;
+		}
+
+		fclose(file);
+	}
+
+	printf("%u cards, %u bits, %u hashes, %u bytes (%.1f bits per card)\n", cardCount, bits,
+			hashes, filter.size, cardCount ? (double)bits / cardCount : 0.0);
+
+	// False-positive rate of k hashes in m bits with n cards: (1 - e^(-kn/m))^k
+	double expected = pow(1 - exp(-(double)hashes * cardCount / bits), hashes);
+
+	if (old.data) {
+		reportPages(&old, &filter, page);
+	}
+
+	bool valid = verify(&memory, expected);
+
+	free(filter.data);
+	free(old.data);
+	free(cards);
+
+	return valid ? 0 : 1;
+}
+
+
+bool parseCSV(const char *path) {
+	FILE *file = fopen(path, "r");
+	char line[MAX_LINE];
+	uint32_t number = 0;
+	uint32_t capacity = 0;
+
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open %s\n", path);
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), file)) {
+		number++;
+
+		char *comment = strchr(line, '#');
+
+		if (comment) {
+			*comment = '\0';
+		}
+
+		char *column = strchr(line, ',');
+
+		if (column) {
+			*column = '\0';
+		}
+
+		// Skip empty lines
+		char *text = line;
+
+		while (isspace((unsigned char)*text)) {
+			text++;
+		}
+
+		if (*text == '\0') {
+			continue;
+		}
+
+		if (cardCount == capacity) {
+			capacity = capacity ? 2 * capacity : 1024;
+			cards = realloc(cards, capacity * sizeof(UID_t));
+		}
+
+		if (!parseUID(text, &cards[cardCount])) {
+			if (number == 1) {
+				continue; // header
+			}
+
+			fprintf(stderr, "%s:%u: invalid UID\n", path, number);
+			fclose(file);
+			return false;
+		}
+
+		cardCount++;
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+
+bool parseUID(const char *text, UID_t *uid) {
+	uint8_t digits = 0;
+
+	memset(uid, 0, sizeof(UID_t));
+
+	for (; *text; text++) {
+		if (*text == ':' || *text == '-' || isspace((unsigned char)*text)) {
+			continue;
+		}
+
+		if (!isxdigit((unsigned char)*text) || digits == 2 * sizeof(uid->UID)) {
+			return false;
+		}
+
+		uint8_t nibble = isdigit((unsigned char)*text) ? *text - '0' : (tolower(*text) - 'a' + 10);
+
+		uid->UID[digits / 2] |= (digits % 2) ? nibble : nibble << 4;
+		digits++;
+	}
+
+	uid->size = digits / 2;
+
+	return (digits % 2) == 0 && (uid->size == 4 || uid->size == 7 || uid->size == 10);
+}
+
+
+int compareUIDs(const void *a, const void *b) {
+	const UID_t *x = a;
+	const UID_t *y = b;
+
+	if (x->size != y->size) {
+		return (x->size < y->size) ? -1 : 1;
+	}
+
+	return memcmp(x->UID, y->UID, x->size);
+}
+
+
+bool isRevoked(const UID_t *uid) {
+	return bsearch(uid, cards, cardCount, sizeof(UID_t), compareUIDs) != NULL;
+}
+
+
+uint8_t readBuffer(void *context, uint32_t address) {
+	const Buffer_t *buffer = context;
+
+	return (address < buffer->size) ? buffer->data[address] : 0;
+}
+
+
+void writeBuffer(void *context, uint32_t address, uint8_t value) {
+	Buffer_t *buffer = context;
+
+	if (address < buffer->size) {
+		buffer->data[address] = value;
+	}
+}
+
+
+bool loadFilter(const char *path, Buffer_t *buffer) {
+	FILE *file = fopen(path, "rb");
+
+	if (file == NULL) {
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	buffer->size = ftell(file);
+	rewind(file);
+	buffer->data = malloc(buffer->size ? buffer->size : 1);
+
+	bool read = fread(buffer->data, 1, buffer->size, file) == buffer->size;
+	DenylistMemory_t memory = {readBuffer, NULL, buffer};
+
+	fclose(file);
+
+	return read && mfrc522_denylistValid(&memory)
+			&& buffer->size == DENYLIST_HEADER + (readWord(buffer->data + 8) + 7) / 8;
+}
+
+
+uint32_t readWord(const uint8_t *data) {
+	return data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+
+void reportPages(const Buffer_t *old, const Buffer_t *filter, uint32_t page) {
+	uint32_t bytes = 0;
+	uint32_t pages = 0;
+	uint32_t erase = 0;
+
+	for (uint32_t start = 0; start < filter->size; start += page) {
+		bool changed = false;
+		bool cleared = false;
+
+		for (uint32_t i = start; i < start + page && i < filter->size; i++) {
+			if (old->data[i] != filter->data[i]) {
+				bytes++;
+				changed = true;
+			}
+
+			// A bit going back to 1 is a card no longer revoked
+			if (filter->data[i] & ~old->data[i]) {
+				cleared = true;
+			}
+		}
+
+		pages += changed;
+		erase += cleared;
+	}
+
+	printf("update: %u bytes in %u pages of %u bytes, %u pages to erase first\n",
+			bytes, pages, page, erase);
+}
+
+
+bool writeSource(const char *path, const char *name, const char *csv, const Buffer_t *filter) {
+	FILE *file = fopen(path, "w");
+
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "\n// Generated by mfrc522_denylist from %s, do not edit.\n", csv);
+	fprintf(file, "// %u revoked cards, see mfrc522_denylist.h\n\n", cardCount);
+	fprintf(file, "#include <stdint.h>\n\n");
+	fprintf(file, "#ifdef __AVR__\n#include <avr/pgmspace.h>\n#else\n#define PROGMEM\n#endif\n\n\n");
+	fprintf(file, "const uint8_t %s[%u] PROGMEM = {", name, filter->size);
+
+	for (uint32_t i = 0; i < filter->size; i++) {
+		fprintf(file, "%s0x%02X%s", (i % 16) ? " " : "\n\t", filter->data[i],
+				(i + 1 < filter->size) ? "," : "");
+	}
+
+	fprintf(file, "\n};\n");
+
+	return fclose(file) == 0;
+}
+
+
+bool verify(const DenylistMemory_t *memory, double rate) {
+	uint32_t missed = 0;
+	uint32_t unknown = 0;
+	uint32_t positives = 0;
+
+	for (uint32_t i = 0; i < cardCount; i++) {
+		missed += !mfrc522_denylistCheck(memory, &cards[i]);
+	}
+
+	srand(1);
+
+	for (uint32_t i = 0; i < RANDOM_UIDS; i++) {
+		UID_t uid = {.size = SIZES[rand() % 3]};
+
+		for (uint8_t b = 0; b < uid.size; b++) {
+			uid.UID[b] = rand();
+		}
+
+		if (!isRevoked(&uid)) {
+			unknown++;
+			positives += mfrc522_denylistCheck(memory, &uid);
+		}
+	}
+
+	printf("verified %u cards: %s, false positives %.3f%% of %u unknown UIDs (expected %.3f%%)\n",
+			cardCount, missed ? "FAILED" : "ok", unknown ? 100.0 * positives / unknown : 0.0,
+			unknown, 100.0 * rate);
+
+	return missed == 0;
+}
+
+
+int query(int count, char **uids) {
+	int result = 0;
+
+	for (int i = 0; i < count; i++) {
+		UID_t uid;
+
+		if (!parseUID(uids[i], &uid)) {
+			fprintf(stderr, "%s: invalid UID\n", uids[i]);
+			return 2;
+		}
+
+		bool revoked = isRevoked(&uid);
+
+		printf("%s: %s\n", uids[i], revoked ? "revoked" : "not revoked");
+		result |= !revoked;
+	}
+
+	return result;
+}
+
+/**************************** End of File ************************************/
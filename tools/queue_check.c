@@ -0,0 +1,260 @@
+//! \file queue_check.c
+//! \brief Check of the lock-free queue of mfrc522_queue.h, producer thread against consumer.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Usage: mfrc522_queue_check [events]
+//!
+//! Every event carries its sequence number in its UID. Three runs:
+//! - the queue filled with no consumer, pushes beyond its capacity refused;
+//! - a producer thread pushing \p events (1000000 by default) against the
+//!   consumer in main(), pushing again until queued: all events must arrive;
+//! - the same without pushing again, with a slow consumer: events are dropped.
+//!
+//! The consumer checks sequence numbers only increase (ordering, no
+//! duplicate), that the numbers missing are exactly the pushes refused (no
+//! loss), and that mfrc522_queueOverflows() counts them.
+//! Exit code is 1 if any check failed.
+
+
+#include "mfrc522_queue.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define EVENTS	1000000
+#define BATCH	4
+
+#define EVENT(seq)	((PresenceEvent_t)(PRESENCE_ARRIVED + (seq) % 3))
+
+// mfrc522_queueOverflows() wraps around, at 16 bits with byte indexes
+#if defined(__AVR__) || defined(__STDC_NO_ATOMICS__) || defined(MFRC522_QUEUE_NO_ATOMICS)
+#define OVERFLOWS(count)	((count) & 0xFFFF)
+#else
+#define OVERFLOWS(count)	(count)
+#endif
+
+
+typedef struct Producer {
+	uint32_t events; // sequence numbers 0 to events - 1
+	bool retry; // push a refused event again until queued
+	uint32_t refused; // pushes that returned false
+	bool done; // set once the last event is pushed
+} Producer_t;
+
+
+typedef struct Consumer {
+	uint32_t received; // events drained
+	uint32_t next; // lowest sequence number expected next
+	uint32_t missing; // sequence numbers skipped
+	uint32_t errors; // events out of order, duplicated or corrupted
+} Consumer_t;
+
+
+static uint32_t ticks; // successful pushes, see tick()
+static uint32_t failures;
+
+
+static void makeUID(UID_t *uid, uint32_t seq);
+static void consume(Consumer_t *consumer, const CardEvent_t *events, uint8_t count);
+static void check(bool passed, const char *format, ...);
+static void *produce(void *arg);
+static uint32_t tick(void);
+static void fill(void);
+static void run(uint32_t events, bool retry);
+
+
+int main(int argc, char **argv) {
+	uint32_t events = (argc > 1) ? strtoul(argv[1], NULL, 0) : EVENTS;
+
+	printf("Queue of %u events\n", MFRC522_QUEUE_SIZE);
+	printf("%-14s %10s %10s %10s %10s %10s\n", "run", "events", "received", "missing", "refused",
+			"overflows");
+
+	fill();
+	run(events, true);
+	run(events, false);
+
+	printf("%s\n", failures ? "FAILED" : "ok");
+
+	return failures ? 1 : 0;
+}
+
+
+void fill() {
+	CardEvent_t events[MFRC522_QUEUE_SIZE + 1];
+	Consumer_t consumer = {0};
+	uint32_t refused = 0;
+	UID_t uid;
+
+	mfrc522_queueInit(tick);
+	ticks = 0;
+
+	for (uint32_t seq = 0; seq < MFRC522_QUEUE_SIZE + 5; seq++) {
+		makeUID(&uid, seq);
+
+		bool queued = mfrc522_queuePush(EVENT(seq), &uid);
+
+		check(queued == (seq < MFRC522_QUEUE_SIZE), "push %u %s", seq, queued ? "queued" : "refused");
+		refused += !queued;
+	}
+
+	uint8_t count = mfrc522_queueDrain(events, MFRC522_QUEUE_SIZE + 1);
+
+	check(count == MFRC522_QUEUE_SIZE, "%u events drained from a full queue", count);
+	consume(&consumer, events, count);
+
+	printf("%-14s %10u %10u %10u %10u %10u\n", "full", MFRC522_QUEUE_SIZE + 5, consumer.received,
+			MFRC522_QUEUE_SIZE + 5 - consumer.next, refused, mfrc522_queueOverflows());
+	check(mfrc522_queueOverflows() == OVERFLOWS(refused), "overflows %u, refused %u",
+			mfrc522_queueOverflows(), refused);
+}
+
+
+void run(uint32_t events, bool retry) {
+	Producer_t producer = {events, retry};
+	Consumer_t consumer = {0};
+	CardEvent_t batch[BATCH];
+	pthread_t thread;
+
+	mfrc522_queueInit(tick);
+	ticks = 0;
+
+	if (pthread_create(&thread, NULL, produce, &producer) != 0) {
+		check(false, "cannot start producer thread");
+		return;
+	}
+
+	while (1) {
+		bool done = __atomic_load_n(&producer.done, __ATOMIC_ACQUIRE);
+		uint8_t count = mfrc522_queueDrain(batch, BATCH);
+
+		// Queue empty after the last push
+		if (count == 0 && done) {
+			break;
+		}
+
+		consume(&consumer, batch, count);
+
+		// Slow consumer, so the queue fills up
+		if (!retry) {
+			usleep(1);
+		}
+		// Let the producer run on a single core
+		else if (count == 0) {
+			sched_yield();
+		}
+	}
+
+	pthread_join(thread, NULL);
+
+	consumer.missing += events - consumer.next;
+
+	printf("%-14s %10u %10u %10u %10u %10u\n", retry ? "thread" : "thread, drops", events,
+			consumer.received, consumer.missing, producer.refused, mfrc522_queueOverflows());
+
+	check(consumer.errors == 0, "%u events out of order, duplicated or corrupted", consumer.errors);
+	check(consumer.received + consumer.missing == events, "%u received, %u missing of %u",
+			consumer.received, consumer.missing, events);
+
+	if (retry) {
+		check(consumer.missing == 0, "%u events lost", consumer.missing);
+	}
+	else {
+		check(consumer.missing == producer.refused, "%u events missing, %u refused",
+				consumer.missing, producer.refused);
+		check(producer.refused > 0, "queue never full");
+	}
+
+	check(mfrc522_queueOverflows() == OVERFLOWS(producer.refused), "overflows %u, refused %u",
+			mfrc522_queueOverflows(), producer.refused);
+}
+
+/**************************** Helper functions *******************************/
+
+void *produce(void *arg) {
+	Producer_t *producer = arg;
+	UID_t uid;
+
+	for (uint32_t seq = 0; seq < producer->events; seq++) {
+		makeUID(&uid, seq);
+
+		while (!mfrc522_queuePush(EVENT(seq), &uid)) {
+			producer->refused++;
+
+			if (!producer->retry) {
+				break;
+			}
+
+			sched_yield();
+		}
+	}
+
+	__atomic_store_n(&producer->done, true, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+
+void consume(Consumer_t *consumer, const CardEvent_t *events, uint8_t count) {
+	for (uint8_t i = 0; i < count; i++) {
+		uint32_t seq;
+
+		memcpy(&seq, events[i].uid.UID, sizeof(seq));
+
+		if (seq < consumer->next || events[i].uid.size != 4 || events[i].event != EVENT(seq)) {
+			check(false, "event %u after %u", seq, consumer->next - 1);
+			consumer->errors++;
+			continue;
+		}
+
+		// now() is called on queued pushes only, they arrive one tick apart
+		if (events[i].time != consumer->received) {
+			check(false, "event %u pushed at tick %u, expected %u", seq, events[i].time,
+					consumer->received);
+			consumer->errors++;
+		}
+
+		consumer->missing += seq - consumer->next;
+		consumer->next = seq + 1;
+		consumer->received++;
+	}
+}
+
+
+void makeUID(UID_t *uid, uint32_t seq) {
+	memset(uid, 0, sizeof(*uid));
+	memcpy(uid->UID, &seq, sizeof(seq));
+	uid->size = 4;
+}
+
+
+uint32_t tick() {
+	return ticks++;
+}
+
+
+void check(bool passed, const char *format, ...) {
+	if (passed) {
+		return;
+	}
+
+	// Only the first failures, a broken queue fails on every event
+	if (failures++ < 10) {
+		va_list args;
+
+		va_start(args, format);
+		printf("FAIL: ");
+		vprintf(format, args);
+		printf("\n");
+		va_end(args);
+	}
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,140 @@
+
+//! \file replay.c
+//! \brief Re-run a recorded MFRC522 trace against the current driver.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! The driver repeats the scan loop of the application
+//! (mfrc522_available(), mfrc522_getID(), mfrc522_sendHaltA())
+//! until the whole trace is replayed, then the access sequence and SPI frames
+//! are compared with the recorded ones.
+//!
+//! Usage: mfrc522_replay [-c clock_hz] [-u ns_per_tick] [-n max_scans] [-i] trace_file
+//! -i: the trace starts before host_mfrc522_init().
+//! Exit code is 1 if the driver diverged from the trace.
+
+
+#include "mfrc522.h"
+#include "mfrc522_replay.h"
+#include "mfrc522_status.h"
+#include "utils_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+static void printAccess(const char *label, uint8_t tag, uint8_t value);
+
+
+int main(int argc, char **argv) {
+	uint32_t clock = 4000000;
+	uint32_t nsPerTick = 1000;
+	uint32_t maxScans = 1000;
+	bool withInit = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:u:n:i")) != -1) {
+		switch (opt) {
+			case 'c':	clock = strtoul(optarg, NULL, 0); break;
+			case 'u':	nsPerTick = strtoul(optarg, NULL, 0); break;
+			case 'n':	maxScans = strtoul(optarg, NULL, 0); break;
+			case 'i':	withInit = true; break;
+			default:
+				fprintf(stderr, "Usage: %s [-c clock_hz] [-u ns_per_tick] [-n max_scans] [-i] trace_file\n", argv[0]);
+				return 2;
+		}
+	}
+
+	if (optind >= argc) {
+		fprintf(stderr, "Usage: %s [-c clock_hz] [-u ns_per_tick] [-n max_scans] [-i] trace_file\n", argv[0]);
+		return 2;
+	}
+
+	FILE *file = fopen(argv[optind], "rb");
+
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open trace file %s\n", argv[optind]);
+		return 2;
+	}
+
+	fseek(file, 0, SEEK_END);
+	uint32_t count = ftell(file) / sizeof(TraceEvent_t);
+	fseek(file, 0, SEEK_SET);
+
+	TraceEvent_t *events = malloc((count ? count : 1) * sizeof(TraceEvent_t));
+
+	if (events == NULL || fread(events, sizeof(TraceEvent_t), count, file) != count) {
+		fprintf(stderr, "Cannot read trace file %s\n", argv[optind]);
+		return 2;
+	}
+
+	fclose(file);
+
+	if (withInit) {
+		mfrc522_replay_load(events, count, nsPerTick);
+	}
+
+	uint64_t start = host_time_ns();
+	host_mfrc522_init(mfrc522_replay_device(), clock);
+
+	if (!withInit) {
+		mfrc522_replay_load(events, count, nsPerTick);
+		start = host_time_ns();
+	}
+
+	UID_t uid;
+	uint32_t scans = 0;
+	uint32_t cards = 0;
+
+	while (!mfrc522_replay_finished() && scans < maxScans) {
+		scans++;
+
+		if (mfrc522_available() && mfrc522_getID(&uid) == STATUS_OK) {
+			cards++;
+			mfrc522_sendHaltA();
+		}
+	}
+
+	uint64_t elapsed = host_time_ns() - start;
+	ReplayReport_t report;
+
+	mfrc522_replay_getReport(&report);
+	free(events);
+
+	printf("%u events, %u scans, %u cards read\n\n", count, scans, cards);
+	printf("%-10s %12s %12s %10s\n", "", "recorded", "replayed", "delta");
+	printf("%-10s %12u %12u %+10d\n", "frames", report.recordedFrames, report.frames,
+			(int)(report.frames - report.recordedFrames));
+	printf("%-10s %12u %12u %+10d\n", "accesses", report.recordedAccesses, report.accesses,
+			(int)(report.accesses - report.recordedAccesses));
+	printf("%-10s %12.1f %12.1f %+10.1f\n", "time_us", report.recordedTime_ns / 1e3,
+			elapsed / 1e3, ((double)elapsed - report.recordedTime_ns) / 1e3);
+
+	printf("\ntrace %s, %u divergences, %u missing, %u extra\n",
+			report.complete ? "complete" : "NOT complete",
+			report.divergences, report.missing, report.extra);
+
+	if (report.divergences) {
+		printf("first divergence at access %u, recorded command %u:\n",
+				report.firstAccess, report.firstCommand);
+		printAccess("  expected", report.expectedTag, report.expectedValue);
+		printAccess("  actual  ", report.actualTag, report.actualValue);
+		return 1;
+	}
+
+	return report.complete ? 0 : 1;
+}
+
+
+void printAccess(const char *label, uint8_t tag, uint8_t value) {
+	if (tag == TRACE_END) {
+		printf("%s end of trace\n", label);
+		return;
+	}
+
+	printf("%s %s reg 0x%02X = 0x%02X\n", label,
+			((tag & TRACE_TYPE) == TRACE_READ) ? "read " : "write", tag & 0x3F, value);
+}
+
+/**************************** End of File ************************************/
@@ -0,0 +1,817 @@
+
+//! \file simulate.c
+//! \brief Run MFRC522 driver against the simulator on a Linux host.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Usage: mfrc522_simulate [SPI clock in Hz, default 4000000] [trace file]
+//! The trace file is decoded by mfrc522_trace.
+//!
+//! The energy/latency trade-off of low-power polling is reported last:
+//! average current and worst-case tap-to-detect latency at a fixed poll interval,
+//! then polls and detection latency of the adaptive scheduler against
+//! fixed-rate polling at its minimum interval.
+//! The event layer is shown on a timeline of card movements.
+//! Reads on a noisy reader are compared without and with a retry policy.
+//! Then the RF front-end is calibrated for a card read through a thick door,
+//! and the SPI clock negotiated over wiring that degrades, which health
+//! checks run between polls detect. Raw frames are compared with the
+//! driver's own commands last.
+
+
+#include "mfrc522.h"
+#include "mfrc522_calibration.h"
+#include "mfrc522_events.h"
+#include "mfrc522_registers.h"
+#include "mfrc522_scheduler.h"
+#include "mfrc522_sim.h"
+#include "mfrc522_status.h"
+#include "mfrc522_stats.h"
+#include "mfrc522_trace.h"
+#include "utils_host.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// Poll interval of the application, and typical supply currents, see mfrc522_stats.h
+#define POLL_INTERVAL_US	100000
+#define POLLS				50
+#define AWAKE_UA			70000
+#define ASLEEP_UA			10
+
+// Scheduler limits, and time a card stays in the field
+#define SCHEDULER_MIN_US	50000
+#define SCHEDULER_MAX_US	1000000
+#define SCHEDULER_BURST_US	5000000
+#define DWELL_US			1000000
+
+// Card taps on a reader mounted on metal: corrupted frames per 1000, time in the field
+#define TAPS				1000
+#define NOISE_PERMILLE		100
+#define TAP_US				200000
+
+// Coupling of the reference card at the edge of the wanted range, activations per test
+#define REFERENCE_COUPLING	45
+#define ACTIVATIONS			100
+#define CALIBRATION_TRIALS	20
+
+// Fastest reliable SPI clock of the wiring, bring-up clock
+#define WIRING_LIMIT		6000000
+#define BRING_UP_CLOCK		1000000
+#define READS				100
+
+// Multiple readers
+#define SCANS				50
+
+
+static void scan(const char *name, SimCard_t **cards, uint8_t count);
+static void report(void);
+static void drain(void);
+static void dutyCycle(const char *name, const LowPower_t *config, SimCard_t *card);
+static void schedule(const char *name, uint32_t seconds, uint32_t every, SimCard_t *card);
+static void timeline(SimCard_t *first, SimCard_t *second);
+static void printEvent(PresenceEvent_t event, const UID_t *uid, void *context);
+static void noisy(const char *name, const RetryPolicy_t *policy, SimCard_t *card);
+static void tuning(const char *name);
+static uint16_t activate(uint16_t coupling, uint16_t count, uint64_t *latency);
+static double readTime(SimCard_t *card);
+static void check(const char *name, uint8_t (*run)(void));
+static void rawFrames(SimCard_t *card);
+static void measureBegin(void);
+static void measureEnd(const char *name, uint8_t status);
+static void readers(uint32_t speed);
+static void scanReaders(const char *field, uint8_t count, bool interleaved, SimCard_t *cards);
+
+static FILE *trace;
+static uint64_t measureStart;
+
+
+int main(int argc, char **argv) {
+	uint32_t speed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 4000000;
+	trace = (argc > 2) ? fopen(argv[2], "wb") : NULL;
+
+	static const uint8_t uid4[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+	static const uint8_t uid4b[4] = {0xDE, 0xAD, 0x3E, 0x01};
+	static const uint8_t uid7[7] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+	static const uint8_t uid10[10] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+
+	static SimCard_t classic, classic2, ultralight, triple;
+
+	mfrc522_sim_createCard(&classic, SIM_CARD_CLASSIC_1K, uid4, 4);
+	mfrc522_sim_createCard(&classic2, SIM_CARD_CLASSIC_1K, uid4b, 4);
+	mfrc522_sim_createCard(&ultralight, SIM_CARD_ULTRALIGHT, uid7, 7);
+	mfrc522_sim_createCard(&triple, SIM_CARD_CLASSIC_1K, uid10, 10);
+
+	mfrc522_sim_init();
+	host_mfrc522_init(mfrc522_sim_device(), speed);
+
+#ifdef MFRC522_STATS
+	mfrc522_statsInit(micros);
+#endif
+
+#ifdef MFRC522_TRACE
+	if (trace) {
+		mfrc522_traceInit(micros);
+	}
+#endif
+
+	printf("SPI clock: %u Hz, init done at %.3f ms\n\n", speed, host_time_ns() / 1e6);
+
+	scan("empty field", NULL, 0);
+	scan("4-byte Classic", (SimCard_t*[]){&classic}, 1);
+	scan("7-byte Ultralight", (SimCard_t*[]){&ultralight}, 1);
+	scan("10-byte Classic", (SimCard_t*[]){&triple}, 1);
+	scan("2 x 4-byte Classic", (SimCard_t*[]){&classic, &classic2}, 2);
+
+	report();
+
+	// Trace holds the scans only, as replayed by mfrc522_replay
+#ifdef MFRC522_TRACE
+	mfrc522_traceEnable(false);
+#endif
+
+	printf("\npolling every %u ms, %u uA awake, %u uA in power-down\n",
+			POLL_INTERVAL_US / 1000, AWAKE_UA, ASLEEP_UA);
+	printf("%-10s %7s %8s %8s %12s %14s %10s\n", "mode", "duty", "avg_uA",
+			"wakeups", "max_wake_us", "max_asleep_us", "detect_us");
+
+	dutyCycle("always-on", NULL, &classic);
+	dutyCycle("low-power", &(LowPower_t){.guard = 5000, .window = 1000}, &classic);
+
+	printf("\nscheduler %u-%u ms, burst %u ms, low-power, fixed rate every %u ms\n",
+			SCHEDULER_MIN_US / 1000, SCHEDULER_MAX_US / 1000,
+			SCHEDULER_BURST_US / 1000, SCHEDULER_MIN_US / 1000);
+	printf("%-14s %6s %8s %8s %14s %14s %12s\n", "phase", "cards", "polls",
+			"fixed", "mean_detect_ms", "max_detect_ms", "interval_ms");
+
+	mfrc522_setLowPower(&(LowPower_t){.guard = 5000, .window = 1000});
+	mfrc522_schedulerInit(&(SchedulerConfig_t){
+			.minInterval = SCHEDULER_MIN_US,
+			.maxInterval = SCHEDULER_MAX_US,
+			.burst = SCHEDULER_BURST_US}, micros);
+
+	schedule("night", 600, 0, &classic);
+	schedule("shift change", 60, 3, &classic);
+	schedule("day", 600, 60, &classic);
+	mfrc522_setLowPower(NULL);
+
+	timeline(&classic, &ultralight);
+
+	printf("\n%u taps of %u ms, %u%% of frames corrupted, UID and page 4 read per tap\n",
+			TAPS, TAP_US / 1000, NOISE_PERMILLE / 10);
+	printf("%-8s %6s %8s %12s %8s %8s %8s\n", "policy", "reads", "success",
+			"time to read", "frames", "wakeups", "resets");
+
+	noisy("none", NULL, &ultralight);
+	noisy("frames", &(RetryPolicy_t){
+			.frames = {[RETRY_ANTICOLLISION] = 2, [RETRY_SELECT] = 2, [RETRY_READ] = 2}}, &ultralight);
+	noisy("restart", &(RetryPolicy_t){
+			.frames = {[RETRY_ANTICOLLISION] = 2, [RETRY_SELECT] = 2, [RETRY_READ] = 2},
+			.wakeups = 2,
+			.fieldResets = 1,
+			.backoff = 500}, &ultralight);
+	mfrc522_setRetryPolicy(NULL);
+
+	CalibrationResult_t result;
+	uint64_t start;
+
+	printf("\nRF calibration, reference card at %u%% coupling, %u%% of frames corrupted\n",
+			REFERENCE_COUPLING, NOISE_PERMILLE / 50);
+	printf("%-10s %10s %8s %12s\n", "tuning", "first try", "range", "time to ID");
+
+	mfrc522_sim_clearField();
+	mfrc522_sim_addCard(&classic);
+	mfrc522_sim_setNoise(NOISE_PERMILLE / 5);
+	tuning("profile");
+
+	mfrc522_sim_setCoupling(REFERENCE_COUPLING);
+	start = host_time_ns();
+	mfrc522_calibrate(NULL, CALIBRATION_TRIALS, micros, &result);
+	tuning("calibrated");
+
+	printf("%u candidates in %.1f s, first try %u/%u before, %u/%u after\n", result.candidates,
+			(host_time_ns() - start) / 1e9, result.before, CALIBRATION_TRIALS,
+			result.after, CALIBRATION_TRIALS);
+	printf("RFCfgReg 0x%02X, RxThresholdReg 0x%02X, DemodReg 0x%02X, "
+			"CWGsPReg 0x%02X, ModGsPReg 0x%02X, GsNReg 0x%02X\n",
+			result.tuning.rxGain, result.tuning.rxThreshold, result.tuning.demod,
+			result.tuning.cwGsP, result.tuning.modGsP, result.tuning.gsN);
+
+	mfrc522_setTuning(NULL);
+	mfrc522_sim_setCoupling(100);
+	mfrc522_sim_setNoise(0);
+
+	printf("\nSPI clock negotiation, wiring reliable up to %.1f MHz\n", WIRING_LIMIT / 1e6);
+
+	printf("%-10s %8s %12s\n", "clock", "MHz", "time to ID");
+
+	host_spi_setLimit(WIRING_LIMIT);
+	host_spi_setClock(BRING_UP_CLOCK);
+	printf("%-10s %8.1f %9.0f us\n", "bring-up", BRING_UP_CLOCK / 1e6, readTime(&classic));
+
+	start = host_time_ns();
+	uint32_t clock = mfrc522_negotiateClock();
+	double negotiation = (host_time_ns() - start) / 1e6;
+
+	printf("%-10s %8.1f %9.0f us, negotiated in %.1f ms\n", "negotiated", clock / 1e6,
+			readTime(&classic), negotiation);
+
+	// Wiring degrades, the periodic check steps the clock down
+	host_spi_setLimit(WIRING_LIMIT / 2);
+	bool passed = mfrc522_verifyClock();
+
+	printf("%-10s %8.1f %9.0f us, limit %.1f MHz, loopback %s\n", "degraded",
+			host_spi_getClock() / 1e6, readTime(&classic), WIRING_LIMIT / 2e6,
+			passed ? "passed" : "failed");
+
+	// Wiring repaired
+	host_spi_setLimit(WIRING_LIMIT);
+	mfrc522_negotiateClock();
+
+	printf("\nHealth checks between polls, SPI clock %.1f MHz\n", host_spi_getClock() / 1e6);
+	printf("%-10s %-12s %10s %10s\n", "check", "result", "accesses", "time");
+
+	check("ping", mfrc522_ping);
+	check("self-test", mfrc522_selfTest);
+	printf("time to ID right after self-test: %.0f us\n", readTime(&classic));
+
+	// Loose connector: checks fail until the clock is negotiated again
+	host_spi_setLimit(BRING_UP_CLOCK / 2);
+	check("ping", mfrc522_ping);
+	check("self-test", mfrc522_selfTest);
+	host_spi_setLimit(WIRING_LIMIT / 2);
+	mfrc522_verifyClock();
+	check("ping", mfrc522_ping);
+
+	Health_t health;
+
+	mfrc522_getHealth(&health);
+	printf("VersionReg 0x%02X, %u/%u pings and %u/%u self-tests failed\n", health.version,
+			health.pingFailures, health.pings, health.selfTestFailures, health.selfTests);
+
+	host_spi_setLimit(0);
+	host_spi_setClock(speed);
+
+	rawFrames(&ultralight);
+	mfrc522_sim_clearField();
+
+	readers(speed);
+
+	if (trace) {
+		fclose(trace);
+	}
+
+	return 0;
+}
+
+
+void scan(const char *name, SimCard_t **cards, uint8_t count) {
+	UID_t uid;
+	SPIStats_t spi;
+	SimStats_t sim;
+
+	mfrc522_sim_clearField();
+
+	for (uint8_t i = 0; i < count; i++) {
+		mfrc522_sim_addCard(cards[i]);
+	}
+
+	host_spi_resetStats();
+	mfrc522_sim_resetStats();
+	uint64_t start = host_time_ns();
+
+	uint8_t status = STATUS_TIMEOUT;
+
+	if (mfrc522_available()) {
+		status = mfrc522_getID(&uid);
+	}
+
+	drain();
+
+	uint64_t elapsed = host_time_ns() - start;
+	host_spi_getStats(&spi);
+	mfrc522_sim_getStats(&sim);
+
+	printf("%s: status %u", name, status);
+
+	if (status == STATUS_OK) {
+		printf(", UID ");
+
+		for (uint8_t i = 0; i < uid.size; i++) {
+			printf("%02X", uid.UID[i]);
+		}
+
+		printf(", SAK %02X", uid.SAK);
+		mfrc522_sendHaltA();
+		drain();
+	}
+
+	printf("\n  %u SPI frames, %u bytes, %.3f ms SPI, %u air frames, %.3f ms air, %.3f ms total\n",
+			spi.frames, spi.bytes, spi.time_ns / 1e6,
+			sim.frames, sim.air_ns / 1e6, elapsed / 1e6);
+}
+
+
+void dutyCycle(const char *name, const LowPower_t *config, SimCard_t *card) {
+#ifdef MFRC522_STATS
+	RFIDStats_t stats;
+	uint64_t start;
+
+	mfrc522_sim_clearField();
+	mfrc522_setLowPower(config);
+	mfrc522_statsReset();
+
+	uint64_t tap = 0;
+
+	for (uint16_t i = 0; i < POLLS; i++) {
+		start = host_time_ns();
+		mfrc522_available();
+		drain();
+
+		// Worst case: the card arrives right after a poll
+		if (i == POLLS - 1) {
+			mfrc522_statsSnapshot(&stats);
+			tap = host_time_ns();
+			mfrc522_sim_addCard(card);
+		}
+
+		host_time_advance(start + POLL_INTERVAL_US * 1000ULL - host_time_ns());
+	}
+
+	while (1) {
+		start = host_time_ns();
+
+		if (mfrc522_available()) {
+			break;
+		}
+
+		host_time_advance(start + POLL_INTERVAL_US * 1000ULL - host_time_ns());
+	}
+
+	uint64_t detect = host_time_ns() - tap;
+
+	mfrc522_sendHaltA();
+	mfrc522_setLowPower(NULL);
+	drain();
+
+	const PowerStats_t *power = &stats.power;
+
+	printf("%-10s %6.1f%% %8u %8u %12u %14u %10.0f\n", name,
+			100.0 * power->awake / (power->awake + power->asleep),
+			mfrc522_statsAverageCurrent(&stats, AWAKE_UA, ASLEEP_UA),
+			power->wakeups, power->maxLatency, power->maxAsleep, detect / 1e3);
+#endif
+}
+
+
+void schedule(const char *name, uint32_t seconds, uint32_t every, SimCard_t *card) {
+	uint64_t end = host_time_ns() + seconds * 1000000000ULL;
+	uint64_t arrival = every ? host_time_ns() + every * 1000000000ULL : end;
+	uint64_t total = 0;
+	uint64_t worst = 0;
+	uint32_t cards = 0;
+	uint32_t polls = 0;
+	bool present = false;
+	bool detected = false;
+	UID_t uid;
+
+	mfrc522_sim_clearField();
+
+	while (host_time_ns() < end) {
+		uint64_t now = host_time_ns();
+
+		if (!present && now >= arrival) {
+			mfrc522_sim_addCard(card);
+			present = true;
+			detected = false;
+			cards++;
+		}
+		else if (present && now >= arrival + DWELL_US * 1000ULL) {
+			mfrc522_sim_removeCard(card);
+			present = false;
+			arrival += every * 1000000000ULL;
+		}
+
+		// Sleep until next poll or next card event
+		uint64_t wake = now + mfrc522_schedulerWait() * 1000ULL;
+		uint64_t event = present ? arrival + DWELL_US * 1000ULL : arrival;
+
+		if (event > now && event < wake) {
+			host_time_advance(event - now);
+			continue;
+		}
+
+		host_time_advance(wake - now);
+		polls++;
+
+		if (mfrc522_schedulerAvailable() && present && !detected) {
+			uint64_t latency = host_time_ns() - arrival;
+
+			detected = true;
+			total += latency;
+			worst = (latency > worst) ? latency : worst;
+			mfrc522_getID(&uid);
+			mfrc522_sendHaltA();
+		}
+	}
+
+	mfrc522_sim_clearField();
+
+	printf("%-14s %6u %8u %8u %14.1f %14.1f %12.1f\n", name, cards, polls,
+			seconds * (1000000 / SCHEDULER_MIN_US),
+			cards ? total / 1e6 / cards : 0.0, worst / 1e6,
+			mfrc522_schedulerInterval() / 1e3);
+}
+
+
+void timeline(SimCard_t *first, SimCard_t *second) {
+	// Card movements, in ms from start: first card wiggles at the edge
+	// of the field for 30ms, then is swapped for the second card.
+	static const struct {
+		uint16_t at;
+		uint8_t card; // 1 = first, 2 = second, 0 = field cleared
+	} moves[] = {{100, 1}, {500, 0}, {530, 1}, {2000, 0}, {2500, 2}, {3000, 1}, {4000, 0}};
+
+	uint64_t start = host_time_ns();
+	uint8_t next = 0;
+
+	printf("\nevents, process every 20 ms, debounce 100 ms, re-report 1000 ms\n");
+	mfrc522_eventsInit(&(EventConfig_t){.debounce = 100000, .rereport = 1000000},
+						printEvent, &start, micros);
+	mfrc522_sim_clearField();
+
+	while (host_time_ns() - start < 4500000000ULL) {
+		uint64_t step = host_time_ns();
+
+		while (next < sizeof(moves) / sizeof(moves[0])
+				&& step - start >= moves[next].at * 1000000ULL) {
+
+			mfrc522_sim_clearField();
+
+			if (moves[next].card) {
+				mfrc522_sim_addCard(moves[next].card == 1 ? first : second);
+			}
+
+			printf("%8.1f ms  field: %s\n", (step - start) / 1e6,
+					moves[next].card ? (moves[next].card == 1 ? "first card" : "second card") : "empty");
+			next++;
+		}
+
+		mfrc522_eventsProcess();
+		host_time_advance(step + 20000000ULL - host_time_ns());
+	}
+
+	mfrc522_sim_clearField();
+}
+
+
+void printEvent(PresenceEvent_t event, const UID_t *uid, void *context) {
+	static const char *names[] = {"none", "ARRIVED", "PRESENT", "REMOVED"};
+	uint64_t start = *(uint64_t*)context;
+
+	printf("%8.1f ms  %-8s ", (host_time_ns() - start) / 1e6, names[event]);
+
+	for (uint8_t i = 0; i < uid->size; i++) {
+		printf("%02X", uid->UID[i]);
+	}
+
+	printf("\n");
+}
+
+
+void noisy(const char *name, const RetryPolicy_t *policy, SimCard_t *card) {
+	RetryStats_t retry;
+	uint32_t reads = 0;
+	uint64_t latency = 0;
+
+	mfrc522_setRetryPolicy(policy);
+	mfrc522_resetRetryStats();
+	mfrc522_sim_setNoise(NOISE_PERMILLE);
+
+	// Every tap: the card enters the field and is polled back to back until read or gone
+	for (uint16_t i = 0; i < TAPS; i++) {
+		uint64_t start = host_time_ns();
+
+		mfrc522_sim_clearField();
+		mfrc522_sim_addCard(card);
+
+		while (host_time_ns() - start < TAP_US * 1000ULL) {
+			UID_t uid;
+			uint8_t page[16];
+
+			if (mfrc522_available() && mfrc522_getID(&uid) == STATUS_OK
+				&& mfrc522_readBlock(4, page) == STATUS_OK) {
+
+				reads++;
+				latency += host_time_ns() - start;
+				break;
+			}
+		}
+	}
+
+	mfrc522_sim_setNoise(0);
+	mfrc522_sim_clearField();
+	mfrc522_getRetryStats(&retry);
+
+	printf("%-8s %6u %7.1f%% %9.2f ms %8u %8u %8u\n", name, reads, 100.0 * reads / TAPS,
+			reads ? latency / 1e6 / reads : 0.0, retry.frames, retry.wakeups, retry.fieldResets);
+}
+
+
+void tuning(const char *name) {
+	uint64_t latency;
+	uint16_t successes = activate(REFERENCE_COUPLING, ACTIVATIONS, &latency);
+	uint16_t coupling = 100;
+
+	// Range: lowest coupling with half of activations at first try
+	while (coupling > 5 && activate(coupling - 5, ACTIVATIONS, NULL) >= ACTIVATIONS / 2) {
+		coupling -= 5;
+	}
+
+	printf("%-10s %6u/%-3u %7u%%", name, successes, ACTIVATIONS, coupling);
+
+	if (successes) {
+		printf(" %9.2f ms\n", latency / 1e6 / successes);
+	}
+	else {
+		printf(" %12s\n", "-");
+	}
+}
+
+
+uint16_t activate(uint16_t coupling, uint16_t count, uint64_t *latency) {
+	uint16_t successes = 0;
+
+	mfrc522_sim_setCoupling(coupling);
+
+	if (latency) {
+		*latency = 0;
+	}
+
+	// Field off and on, as a card presented anew
+	for (uint16_t i = 0; i < count; i++) {
+		UID_t uid;
+
+		mfrc522_powerDown();
+		mfrc522_wakeUp();
+
+		uint64_t start = host_time_ns();
+
+		if (mfrc522_available() && mfrc522_getID(&uid) == STATUS_OK) {
+			successes++;
+
+			if (latency) {
+				*latency += host_time_ns() - start;
+			}
+		}
+	}
+
+	return successes;
+}
+
+
+double readTime(SimCard_t *card) {
+	UID_t uid;
+	uint64_t time = 0;
+
+	// Card taps, SPI and air time of REQA, anticollision and SELECT
+	for (uint16_t i = 0; i < READS; i++) {
+		mfrc522_sim_clearField();
+		mfrc522_sim_addCard(card);
+
+		uint64_t start = host_time_ns();
+
+		mfrc522_available();
+		mfrc522_getID(&uid);
+		time += host_time_ns() - start;
+	}
+
+	return time / 1e3 / READS;
+}
+
+
+void check(const char *name, uint8_t (*run)(void)) {
+	SimStats_t before, after;
+
+	mfrc522_sim_getStats(&before);
+	uint64_t start = host_time_ns();
+
+	uint8_t status = run();
+	double time = (host_time_ns() - start) / 1e3;
+
+	mfrc522_sim_getStats(&after);
+
+	printf("%-10s %-12s %10u %7.0f us\n", name,
+			status == STATUS_OK ? "passed" : status == STATUS_INVALID ? "no reference" : "failed",
+			(after.regReads + after.regWrites) - (before.regReads + before.regWrites), time);
+}
+
+
+void rawFrames(SimCard_t *card) {
+	static const uint8_t READ_PAGE4[2] = {MIFARE_CMD_READ, 4};
+	static const uint8_t HLTA[2] = {MIFARE_CMD_HALT, 0x00};
+	static const uint8_t WUPA = MIFARE_CMD_WUPA;
+	uint8_t page[16], raw[16], atqa[2];
+	RFIDFrame_t rx = {raw, sizeof(raw)};
+	RFIDFrame_t answer = {atqa, sizeof(atqa)};
+	UID_t uid;
+	uint8_t status;
+
+	printf("\nRaw frames, Ultralight, SPI clock %.1f MHz\n", host_spi_getClock() / 1e6);
+	printf("%-24s %6s %10s %8s %8s\n", "call", "status", "SPI frames", "bytes", "time");
+
+	mfrc522_sim_clearField();
+	mfrc522_sim_addCard(card);
+	mfrc522_available();
+	mfrc522_getID(&uid);
+
+	measureBegin();
+	status = mfrc522_readBlock(4, page);
+	measureEnd("readBlock page 4", status);
+
+	// CRC_A appended by the reader while sending, instead of the CRC coprocessor
+	measureBegin();
+	status = mfrc522_transceiveRaw(READ_PAGE4, sizeof(READ_PAGE4),
+			&(RFIDFraming_t){.txCRC = true, .rxCRC = true}, &rx);
+	measureEnd("raw READ, TxCRCEn", status);
+
+	measureBegin();
+	status = mfrc522_transceiveRaw(HLTA, sizeof(HLTA), &(RFIDFraming_t){.txCRC = true}, NULL);
+	measureEnd("raw HLTA, transmit only", status);
+
+	measureBegin();
+	status = mfrc522_transceiveRaw(&WUPA, 1, &(RFIDFraming_t){.txLastBits = 7}, &answer);
+	measureEnd("raw WUPA, short frame", status);
+
+	// Rejected before any register access
+	measureBegin();
+	status = mfrc522_transceiveRaw(&WUPA, 1, &(RFIDFraming_t){.txLastBits = 8}, &answer);
+	measureEnd("raw WUPA, txLastBits 8", status);
+
+	measureBegin();
+	status = mfrc522_transceiveRaw(READ_PAGE4, sizeof(READ_PAGE4),
+			&(RFIDFraming_t){.rxAlign = 8}, &rx);
+	measureEnd("raw READ, rxAlign 8", status);
+
+	printf("pages read %s, ATQA %02X%02X from the halted card\n",
+			memcmp(page, raw, sizeof(page)) == 0 ? "alike" : "differ", atqa[1], atqa[0]);
+}
+
+
+void readers(uint32_t speed) {
+	static SimCard_t cards[SIM_MAX_READERS];
+
+	printf("\n%u readers, one SSI module each, SPI clock %.1f MHz, %u scans per reader\n",
+			SIM_MAX_READERS, speed / 1e6, SCANS);
+	printf("%-6s %8s %-12s %10s %6s\n", "field", "readers", "polling", "scans/s", "IDs");
+
+	for (uint8_t i = 0; i < SIM_MAX_READERS; i++) {
+		uint8_t uid[4] = {0x04, 0xC0, 0xFF, 0xE0 + i};
+
+		mfrc522_sim_createCard(&cards[i], SIM_CARD_CLASSIC_1K, uid, 4);
+	}
+
+	scanReaders("idle", 1, false, NULL);
+	scanReaders("idle", SIM_MAX_READERS, false, NULL);
+	scanReaders("idle", SIM_MAX_READERS, true, NULL);
+	scanReaders("busy", 1, false, cards);
+	scanReaders("busy", 1, true, cards);
+	scanReaders("busy", SIM_MAX_READERS, false, cards);
+	scanReaders("busy", SIM_MAX_READERS, true, cards);
+
+	mfrc522_sim_useReader(0);
+}
+
+
+void scanReaders(const char *field, uint8_t count, bool interleaved, SimCard_t *cards) {
+	static HostPort_t ports[SIM_MAX_READERS];
+	static RFIDReader_t readers[SIM_MAX_READERS];
+	uint16_t ids = 0;
+
+	for (uint8_t i = 0; i < count; i++) {
+		mfrc522_sim_useReader(i);
+		mfrc522_sim_init();
+
+		ports[i] = (HostPort_t){.device = mfrc522_sim_device(), .clock = host_spi_getClock()};
+		host_mfrc522_initReader(&readers[i], &ports[i]);
+	}
+
+	uint64_t start = host_time_ns();
+
+	for (uint16_t n = 0; n < SCANS; n++) {
+		uint8_t found = 0;
+
+		// Busy: a new card in front of every reader at every scan
+		for (uint8_t i = 0; cards && i < count; i++) {
+			mfrc522_sim_useReader(i);
+			mfrc522_sim_removeCard(&cards[i]);
+			mfrc522_sim_addCard(&cards[i]);
+		}
+
+		if (interleaved) {
+			UID_t uids[SIM_MAX_READERS];
+
+			found = mfrc522_pollReaders(readers, count);
+			found = mfrc522_getIDs(readers, count, found, uids);
+		}
+		else {
+			for (uint8_t i = 0; i < count; i++) {
+				UID_t uid;
+
+				mfrc522_useReader(&readers[i]);
+
+				if (mfrc522_available() && mfrc522_getID(&uid) == STATUS_OK) {
+					found |= 1 << i;
+				}
+			}
+		}
+
+		for (uint8_t i = 0; i < count; i++) {
+			ids += (found >> i) & 1;
+		}
+	}
+
+	double seconds = (host_time_ns() - start) / 1e9;
+
+	printf("%-6s %8u %-12s %10.1f %6u\n", field, count,
+			interleaved ? "interleaved" : "in turn", SCANS * count / seconds, ids);
+
+	for (uint8_t i = 0; i < count; i++) {
+		mfrc522_sim_useReader(i);
+		mfrc522_sim_clearField();
+	}
+}
+
+
+void measureBegin(void) {
+	host_spi_resetStats();
+	measureStart = host_time_ns();
+}
+
+
+void measureEnd(const char *name, uint8_t status) {
+	SPIStats_t spi;
+
+	host_spi_getStats(&spi);
+
+	printf("%-24s %6u %10u %8u %5.0f us\n", name, status, spi.frames, spi.bytes,
+			(host_time_ns() - measureStart) / 1e3);
+}
+
+
+void drain(void) {
+#ifdef MFRC522_TRACE
+	TraceEvent_t events[64];
+	uint16_t count;
+
+	if (trace == NULL) {
+		return;
+	}
+
+	while ((count = mfrc522_traceRead(events, 64)) > 0) {
+		fwrite(events, sizeof(TraceEvent_t), count, trace);
+	}
+#endif
+}
+
+
+void report(void) {
+#ifdef MFRC522_STATS
+	static const char *names[STATS_FRAMES] = {"REQA/WUPA", "ANTICOLL", "SELECT", "HALT",
+												"AUTH", "READ", "WRITE", "CRC", "other"};
+	RFIDStats_t stats;
+
+	mfrc522_statsSnapshot(&stats);
+
+	printf("%-10s %6s %6s %6s %6s %6s %8s  latency log2(us): count\n",
+			"frame", "ok", "coll", "tmo", "hung", "other", "polls");
+
+	for (uint8_t i = 0; i < STATS_FRAMES; i++) {
+		const FrameStats_t *frame = &stats.frame[i];
+		uint32_t other = 0;
+
+		for (uint8_t s = 0; s < MFRC522_STATS_STATUS; s++) {
+			if (s != STATUS_OK && s != STATUS_COLLISION && s != STATUS_TIMEOUT
+				&& s != MFRC522_STATS_HUNG) {
+				other += frame->status[s];
+			}
+		}
+
+		printf("%-10s %6u %6u %6u %6u %6u %8u ", names[i], frame->status[STATUS_OK],
+				frame->status[STATUS_COLLISION], frame->status[STATUS_TIMEOUT],
+				frame->status[MFRC522_STATS_HUNG], other, frame->polls);
+
+		for (uint8_t b = 0; b < MFRC522_STATS_BUCKETS; b++) {
+			if (frame->latency[b]) {
+				printf(" %u:%u", b, frame->latency[b]);
+			}
+		}
+
+		printf("\n");
+	}
+#endif
+}
+
+/**************************** End of File ************************************/
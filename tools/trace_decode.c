@@ -0,0 +1,371 @@
+
+//! \file trace_decode.c
+//! \brief Decode MFRC522 binary trace into ISO 14443A protocol log.
+//! \author Nguyen Trong Phuong (aka trongphuongpro)
+//! \date 2026 Oct 18
+//!
+//! Input is a file of TraceEvent_t (see mfrc522_trace.h), as drained from the ring.
+//! Every command is printed with its tx/rx frames, status, duration and polls,
+//! followed by time spent per phase (REQA/WUPA, ANTICOLL, SELECT, ...).
+//!
+//! Usage: mfrc522_trace [-u ns_per_tick] [-r] trace_file
+//! -u: clock unit of timestamps, default 1000 (1us).
+//! -r: also print every register access.
+
+
+#include "mfrc522_trace.h"
+#include "mfrc522_registers.h"
+#include "mfrc522_status.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define MAX_FRAME	64
+
+typedef enum Phase {
+	PHASE_REQUEST,
+	PHASE_ANTICOLL,
+	PHASE_SELECT,
+	PHASE_HALT,
+	PHASE_AUTH,
+	PHASE_READ,
+	PHASE_WRITE,
+	PHASE_CRC,
+	PHASE_OTHER,
+	PHASES
+} Phase_t;
+
+
+typedef struct Command {
+	uint8_t command;
+	uint64_t start;
+	uint8_t tx[MAX_FRAME];
+	uint8_t txSize;
+	uint8_t rx[MAX_FRAME];
+	uint8_t rxSize;
+	uint8_t bitFraming;
+	uint8_t rxLastBits;
+	uint32_t polls;
+	uint32_t accesses;
+} Command_t;
+
+
+typedef struct PhaseTime {
+	uint32_t count;
+	uint64_t total;
+	uint64_t max;
+	uint32_t polls;
+} PhaseTime_t;
+
+
+static const char *PHASE_NAMES[PHASES] = {"REQA/WUPA", "ANTICOLL", "SELECT", "HALT",
+											"AUTH", "READ", "WRITE", "CRC", "other"};
+
+static const char *REGISTER_NAMES[64] = {
+	"Reserved00", "CommandReg", "ComIEnReg", "DivIEnReg", "ComIrqReg", "DivIrqReg",
+	"ErrorReg", "Status1Reg", "Status2Reg", "FIFODataReg", "FIFOLevelReg", "WaterLevelReg",
+	"ControlReg", "BitFramingReg", "CollReg", "Reserved0F",
+	"Reserved10", "ModeReg", "TxModeReg", "RxModeReg", "TxControlReg", "TxASKReg",
+	"TxSelReg", "RxSelReg", "RxThresholdReg", "DemodReg", "Reserved1A", "Reserved1B",
+	"MifareReg", "MfRxReg", "Reserved1E", "SerialSpeedReg",
+	"Reserved20", "CRCResultRegMSB", "CRCResultRegLSB", "Reserved23", "ModWidthReg",
+	"Reserved25", "RFCfgReg", "GsNReg", "CWGsPReg", "ModGsPReg", "TModeReg",
+	"TPrescalerReg", "TReloadRegH", "TReloadRegL", "TCounterValueRegH", "TCounterValueRegL",
+	"Reserved30", "TestSel1Reg", "TestSel2Reg", "TestPinEnReg", "TestPinValueReg",
+	"TestBusReg", "AutoTestReg", "VersionReg", "AnalogTestReg", "TestDAC1Reg",
+	"TestDAC2Reg", "TestADCReg", "Reserved3C", "Reserved3D", "Reserved3E", "Reserved3F"
+};
+
+static uint64_t nsPerTick = 1000;
+static bool registers = false;
+static PhaseTime_t phases[PHASES];
+
+static const char* commandName(uint8_t command);
+static const char* statusName(uint8_t status);
+static Phase_t describe(const Command_t *cmd, char *text, size_t size);
+static void printFrame(const char *label, const uint8_t *data, uint8_t size, uint8_t lastBits);
+static void finish(Command_t *cmd, uint64_t time, uint8_t status);
+
+
+int main(int argc, char **argv) {
+	int opt;
+
+	while ((opt = getopt(argc, argv, "u:r")) != -1) {
+		switch (opt) {
+			case 'u':	nsPerTick = strtoull(optarg, NULL, 0); break;
+			case 'r':	registers = true; break;
+			default:
+				fprintf(stderr, "Usage: %s [-u ns_per_tick] [-r] trace_file\n", argv[0]);
+				return 2;
+		}
+	}
+
+	if (optind >= argc) {
+		fprintf(stderr, "Usage: %s [-u ns_per_tick] [-r] trace_file\n", argv[0]);
+		return 2;
+	}
+
+	FILE *file = fopen(argv[optind], "rb");
+
+	if (file == NULL) {
+		fprintf(stderr, "Cannot open trace file %s\n", argv[optind]);
+		return 2;
+	}
+
+	Command_t cmd;
+	bool inCommand = false;
+	bool crcInside = false;
+	uint8_t raw[4];
+	uint16_t last = 0;
+	uint64_t time = 0;
+	uint8_t lastReg = 0;
+	uint8_t lastValue = 0;
+	uint32_t events = 0;
+
+	memset(&cmd, 0, sizeof(cmd));
+
+	while (fread(raw, sizeof(raw), 1, file) == 1) {
+		uint16_t stamp = raw[0] | (raw[1] << 8);
+		uint8_t tag = raw[2];
+		uint8_t value = raw[3];
+		uint32_t repeat = 1;
+
+		// unwrap 16-bit timestamps
+		time += (uint16_t)(stamp - last) * nsPerTick;
+		last = stamp;
+		events++;
+
+		if (tag == TRACE_REPEAT) {
+			repeat = value;
+			tag = TRACE_READ | lastReg;
+			value = lastValue;
+		}
+
+		switch (tag & TRACE_TYPE) {
+			case TRACE_WRITE:
+			case TRACE_READ: {
+				uint8_t reg = tag & 0x3F;
+				bool read = (tag & TRACE_TYPE) == TRACE_READ;
+
+				if (registers) {
+					printf("%12.3f     %s %-16s %02X%s\n", time / 1e3, read ? "R" : "W",
+							REGISTER_NAMES[reg], value, (repeat > 1) ? " (repeated)" : "");
+				}
+
+				if (read) {
+					lastReg = reg;
+					lastValue = value;
+				}
+
+				// CRC check of received frame runs inside the command
+				if (!inCommand || crcInside) {
+					break;
+				}
+
+				cmd.accesses += repeat;
+
+				if (read && (reg == ComIrqReg || reg == DivIrqReg)) {
+					cmd.polls += repeat;
+				}
+
+				if (!read && reg == FIFOLevelReg && (value & BIT_7)) {
+					cmd.txSize = 0;
+				}
+				else if (!read && reg == FIFODataReg && cmd.txSize < MAX_FRAME) {
+					cmd.tx[cmd.txSize++] = value;
+				}
+				else if (!read && reg == BitFramingReg && !(value & BIT_7)) {
+					cmd.bitFraming = value;
+				}
+				else if (read && reg == ControlReg) {
+					cmd.rxLastBits = value & 0x07;
+				}
+				else if (read && reg == FIFODataReg) {
+					for (uint32_t i = 0; i < repeat && cmd.rxSize < MAX_FRAME; i++) {
+						cmd.rx[cmd.rxSize++] = value;
+					}
+				}
+				break;
+			}
+
+			default:
+				if ((tag & 0xF0) == TRACE_BEGIN) {
+					if (inCommand) {
+						crcInside = true;
+						break;
+					}
+
+					memset(&cmd, 0, sizeof(cmd));
+					cmd.command = tag & 0x0F;
+					cmd.start = time;
+					inCommand = true;
+				}
+				else if ((tag & 0xF0) == TRACE_END) {
+					if (crcInside) {
+						crcInside = false;
+						phases[PHASE_CRC].count++;
+						break;
+					}
+
+					finish(&cmd, time, value);
+					inCommand = false;
+				}
+				break;
+		}
+	}
+
+	fclose(file);
+
+	printf("\n%u events, %.3f ms\n\n", events, time / 1e6);
+	printf("%-10s %8s %12s %12s %10s\n", "phase", "count", "total_us", "max_us", "polls");
+
+	for (uint8_t i = 0; i < PHASES; i++) {
+		const PhaseTime_t *phase = &phases[i];
+
+		if (phase->count) {
+			printf("%-10s %8u %12.1f %12.1f %10u\n", PHASE_NAMES[i], phase->count,
+					phase->total / 1e3, phase->max / 1e3, phase->polls);
+		}
+	}
+
+	return 0;
+}
+
+
+void finish(Command_t *cmd, uint64_t time, uint8_t status) {
+	char text[64];
+	uint64_t duration = time - cmd->start;
+	Phase_t phase = describe(cmd, text, sizeof(text));
+
+	phases[phase].count++;
+	phases[phase].total += duration;
+	phases[phase].polls += cmd->polls;
+
+	if (duration > phases[phase].max) {
+		phases[phase].max = duration;
+	}
+
+	printf("%12.3f  %-10s %-24s", cmd->start / 1e3, commandName(cmd->command), text);
+	printFrame("tx", cmd->tx, cmd->txSize, cmd->bitFraming & 0x07);
+
+	if (cmd->rxSize) {
+		printFrame("  rx", cmd->rx, cmd->rxSize, cmd->rxLastBits);
+	}
+
+	printf("  -> %s, %.1f us, %u polls, %u accesses\n", statusName(status),
+			duration / 1e3, cmd->polls, cmd->accesses);
+}
+
+
+Phase_t describe(const Command_t *cmd, char *text, size_t size) {
+	const uint8_t *tx = cmd->tx;
+
+	text[0] = '\0';
+
+	if (cmd->command == MFRC522_CMD_CALCCRC) {
+		snprintf(text, size, "CRC_A");
+		return PHASE_CRC;
+	}
+
+	if (cmd->command == MFRC522_CMD_AUTHENT) {
+		if (cmd->txSize >= 2) {
+			snprintf(text, size, "AUTH key %c block %u", (tx[0] == MIFARE_CMD_AUTHENT1B) ? 'B' : 'A', tx[1]);
+		}
+		return PHASE_AUTH;
+	}
+
+	if (cmd->txSize == 0) {
+		return PHASE_OTHER;
+	}
+
+	if (cmd->txSize == 18) {
+		snprintf(text, size, "WRITE data");
+		return PHASE_WRITE;
+	}
+
+	switch (tx[0]) {
+		case MIFARE_CMD_REQA:
+			snprintf(text, size, "REQA");
+			return PHASE_REQUEST;
+
+		case MIFARE_CMD_WUPA:
+			snprintf(text, size, "WUPA");
+			return PHASE_REQUEST;
+
+		case MIFARE_CMD_SELECTCL1: case MIFARE_CMD_SELECTCL2: case MIFARE_CMD_SELECTCL3: {
+			uint8_t level = (tx[0] - MIFARE_CMD_SELECTCL1) / 2 + 1;
+			uint8_t nvb = (cmd->txSize > 1) ? tx[1] : 0;
+
+			if (nvb == 0x70) {
+				snprintf(text, size, "SELECT CL%u", level);
+				return PHASE_SELECT;
+			}
+
+			snprintf(text, size, "ANTICOLL CL%u NVB %02X", level, nvb);
+			return PHASE_ANTICOLL;
+		}
+
+		case MIFARE_CMD_HALT:
+			snprintf(text, size, "HLTA");
+			return PHASE_HALT;
+
+		case MIFARE_CMD_READ:
+			snprintf(text, size, "READ block %u", (cmd->txSize > 1) ? tx[1] : 0);
+			return PHASE_READ;
+
+		case MIFARE_CMD_WRITE:
+			snprintf(text, size, "WRITE block %u", (cmd->txSize > 1) ? tx[1] : 0);
+			return PHASE_WRITE;
+
+		default:
+			return PHASE_OTHER;
+	}
+}
+
+
+void printFrame(const char *label, const uint8_t *data, uint8_t size, uint8_t lastBits) {
+	printf("%s", label);
+
+	for (uint8_t i = 0; i < size; i++) {
+		printf(" %02X", data[i]);
+	}
+
+	if (lastBits) {
+		printf(" (%u bits)", lastBits);
+	}
+}
+
+
+const char* commandName(uint8_t command) {
+	switch (command) {
+		case MFRC522_CMD_IDLE:			return "IDLE";
+		case MFRC522_CMD_CALCCRC:		return "CALCCRC";
+		case MFRC522_CMD_TRANSMIT:		return "TRANSMIT";
+		case MFRC522_CMD_RECEIVE:		return "RECEIVE";
+		case MFRC522_CMD_TRANSCEIVE:	return "TRANSCEIVE";
+		case MFRC522_CMD_AUTHENT:		return "AUTHENT";
+		case MFRC522_CMD_SOFTRESET:		return "SOFTRESET";
+		default:						return "?";
+	}
+}
+
+
+const char* statusName(uint8_t status) {
+	switch (status) {
+		case STATUS_OK:					return "OK";
+		case STATUS_ERROR:				return "ERROR";
+		case STATUS_COLLISION:			return "COLLISION";
+		case STATUS_TIMEOUT:			return "TIMEOUT";
+		case STATUS_NO_ROOM:			return "NO_ROOM";
+		case STATUS_INTERNAL_ERROR:		return "INTERNAL_ERROR";
+		case STATUS_INVALID:			return "INVALID";
+		case STATUS_CRC_WRONG:			return "CRC_WRONG";
+		case STATUS_MIFARE_NACK:		return "MIFARE_NACK";
+		default:						return "?";
+	}
+}
+
+/**************************** End of File ************************************/